@@ -0,0 +1,113 @@
+#!/usr/bin/env python
+
+# Compares the lossless depth and label codec with zlib: compression ratio
+# and time per frame, on synthetic scenes, on frames of the simulated device
+# and on recorded frames given as .npy files (2D uint16 arrays, or stacks of
+# them) on the command line. Does not require a sensor.
+
+import sys
+sys.path.insert(1, '../build')
+
+from pynuitrack import Nuitrack, compress_depth, compress_labels, decompress
+import numpy as np
+import time
+import zlib
+
+ROWS, COLS, FRAMES = 480, 640, 30
+
+def noisy_ramp(n):
+    """Same scene as bench_depth_filter.py: uniform noise and random holes."""
+    rng = np.random.RandomState(0)
+    y, x = np.mgrid[0:ROWS, 0:COLS]
+    scene = (1500 + 2 * y + 800 * (x > COLS / 2)).astype(np.uint16)
+    for _ in range(n):
+        noise = rng.randint(-8, 9, (ROWS, COLS))
+        frame = np.clip(scene + noise, 0, 65535).astype(np.uint16)
+        frame[rng.rand(ROWS, COLS) < 0.05] = 0
+        yield frame
+
+def simulated(n):
+    """Depth and label frames of the simulated device."""
+    depth, labels = [], []
+    nt = Nuitrack()
+    nt.set_depth_callback(depth.append)
+    nt.set_user_callback(labels.append)
+    nt.init("", "sim:0:3")
+    for _ in range(n):
+        nt.update()
+    nt.release()
+    return depth, labels
+
+def with_sensor_noise(frames):
+    """Adds the disparity quantization and edge holes of a structured-light
+    sensor to clean frames."""
+    rng = np.random.RandomState(1)
+    for frame in frames:
+        z = frame.astype(np.float64)
+        valid = z > 0
+        # Depth steps grow with the square of the distance.
+        step = 1.5e-6 * z ** 2 + 1
+        z = np.round(z / step + rng.normal(0, 0.3, z.shape)) * step
+        z[~valid] = 0
+        # Shadows at depth discontinuities.
+        edges = np.abs(np.diff(frame.astype(np.int32), axis=1)) > 100
+        z[:, 1:][edges] = 0
+        z[:, :-1][edges] = 0
+        yield np.clip(z, 0, 65535).astype(np.uint16)
+
+def recorded(paths):
+    for path in paths:
+        data = np.load(path)
+        for frame in data.reshape((-1,) + data.shape[-2:]):
+            yield frame.astype(np.uint16)
+
+def measure(frames, compress):
+    raw = encoded = 0
+    encode = decode = 0.0
+    for frame in frames:
+        start = time.time()
+        data = compress(frame)
+        encode += time.time() - start
+        start = time.time()
+        back = decompress(data)
+        decode += time.time() - start
+        assert np.array_equal(back, frame)
+        raw += frame.nbytes
+        encoded += len(data)
+    return raw / float(encoded), 1000 * encode / len(frames), \
+           1000 * decode / len(frames)
+
+def measure_zlib(frames, level):
+    raw = encoded = 0
+    encode = decode = 0.0
+    for frame in frames:
+        start = time.time()
+        data = zlib.compress(frame.tobytes(), level)
+        encode += time.time() - start
+        start = time.time()
+        np.frombuffer(zlib.decompress(data), np.uint16).reshape(frame.shape)
+        decode += time.time() - start
+        raw += frame.nbytes
+        encoded += len(data)
+    return raw / float(encoded), 1000 * encode / len(frames), \
+           1000 * decode / len(frames)
+
+sim_depth, sim_labels = simulated(FRAMES)
+scenes = [
+    ("noisy ramp", list(noisy_ramp(FRAMES)), compress_depth),
+    ("simulated depth", sim_depth, compress_depth),
+    ("simulated + noise", list(with_sensor_noise(sim_depth)), compress_depth),
+    ("simulated labels", sim_labels, compress_labels),
+]
+if len(sys.argv) > 1:
+    scenes.append(("recorded", list(recorded(sys.argv[1:])), compress_depth))
+
+print("%-20s %-8s %7s %10s %10s" % ("scene", "codec", "ratio",
+                                     "encode ms", "decode ms"))
+for name, frames, compress in scenes:
+    results = [("pynuitrack", measure(frames, compress)),
+               ("zlib -1", measure_zlib(frames, 1)),
+               ("zlib -6", measure_zlib(frames, 6))]
+    for codec, (ratio, encode, decode) in results:
+        print("%-20s %-8s %7.2f %10.3f %10.3f" % (name, codec, ratio,
+                                                  encode, decode))
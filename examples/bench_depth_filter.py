@@ -0,0 +1,44 @@
+#!/usr/bin/env python
+
+# Measures the cost of each depth filter stage on synthetic 640x480 frames.
+# Does not require a sensor.
+
+import sys
+sys.path.insert(1, '../build')
+
+from pynuitrack import Nuitrack
+import numpy as np
+
+ROWS, COLS, FRAMES = 480, 640, 200
+
+def synthetic_frames(n):
+    rng = np.random.RandomState(0)
+    y, x = np.mgrid[0:ROWS, 0:COLS]
+    scene = (1500 + 2 * y + 800 * (x > COLS / 2)).astype(np.uint16)
+    for _ in range(n):
+        noise = rng.randint(-8, 9, (ROWS, COLS))
+        frame = np.clip(scene + noise, 0, 65535).astype(np.uint16)
+        frame[rng.rand(ROWS, COLS) < 0.05] = 0
+        yield frame
+
+stages = [
+    ("hole filling", dict(hole_fill=8)),
+    ("temporal ema", dict(temporal="ema")),
+    ("temporal median (3)", dict(temporal="median", median_window=3)),
+    ("temporal median (5)", dict(temporal="median", median_window=5)),
+    ("edge-preserving", dict(edge_threshold=30)),
+    ("full chain", dict(hole_fill=8, temporal="median", edge_threshold=30)),
+]
+
+nt = Nuitrack()
+frames = list(synthetic_frames(FRAMES))
+
+for name, config in stages:
+    nt.set_depth_filter(**config)
+    for frame in frames:
+        nt.filter_depth(frame)
+    stats = nt.get_depth_filter_stats(offline=True)
+    print("%-22s fill/temporal %6.3f ms   edge %6.3f ms" % (
+        name,
+        stats["fill_temporal_ms"] / stats["frames"],
+        stats["edge_ms"] / stats["frames"]))
@@ -0,0 +1,107 @@
+// Measures the native processing cost per frame of the simulated device,
+// without Python, for several processing chains. Does not require a sensor.
+//
+// Built with -DBUILD_NATIVE_BENCHMARKS=ON:
+//
+//   ./bench_tracker [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include "tracker.hpp"
+
+/// Processing chain being measured.
+struct Scenario
+{
+    /// Name printed in the results.
+    const char *name;
+
+    /// Configures the tracker before it is initialized.
+    std::function<void(Tracker &)> configure;
+};
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 300;
+
+    uint64_t compressedFrames = 0;
+    uint64_t compressedBytes = 0;
+    auto onDepth = [](const DepthImage &) {};
+    auto onCompressed = [&](const CompressedImage &image)
+    {
+        compressedFrames++;
+        compressedBytes += image.size;
+    };
+    auto onSkeletons = [](const SkeletonFrame &) {};
+
+    Scenario scenarios[] = {
+        {"callbacks only", [&](Tracker &t)
+         {
+             t.setDepthCallback(onDepth);
+             t.setSkeletonCallback(onSkeletons);
+         }},
+        {"depth filters", [&](Tracker &t)
+         {
+             DepthFilterConfig config;
+             config.holeFill = 8;
+             config.temporal = TEMPORAL_MEDIAN;
+             config.edgeThreshold = 30;
+             t.setDepthFilter(config);
+             t.setDepthCallback(onDepth);
+         }},
+        {"compressed depth", [&](Tracker &t)
+         {
+             t.setCompressedDepthCallback(onCompressed);
+         }},
+        {"history + gestures", [&](Tracker &t)
+         {
+             std::vector<float> gesture(30 * HISTORY_JOINTS * 3, 0.0f);
+             t.setHistoryCapacity(300);
+             t.addGestureTemplate(gesture.data(), 30, 1.0f);
+             t.setSkeletonCallback(onSkeletons);
+         }},
+        {"voxel grid", [&](Tracker &t)
+         {
+             VoxelGridConfig config;
+             config.origin[0] = -2000;
+             config.origin[1] = -1500;
+             config.origin[2] = 500;
+             config.voxelSize = 50;
+             config.nx = 80;
+             config.ny = 60;
+             config.nz = 80;
+             t.setVoxelGrid(config);
+         }},
+    };
+
+    std::printf("%-22s %10s %8s\n", "scenario", "ms/frame", "ratio");
+    for (Scenario &scenario : scenarios)
+    {
+        compressedFrames = compressedBytes = 0;
+        Tracker tracker;
+        scenario.configure(tracker);
+        tracker.init("", "sim:0:3");
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+            tracker.update();
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        StreamMode mode = tracker.depthMode();
+        tracker.release();
+
+        std::printf("%-22s %10.3f", scenario.name, elapsed.count() / frames);
+        if (compressedBytes)
+        {
+            // Size of the raw frames over the size of the compressed ones.
+            double raw = (double)compressedFrames * mode.xres * mode.yres *
+                         sizeof(uint16_t);
+            std::printf(" %8.2f", raw / compressedBytes);
+        }
+        std::printf("\n");
+    }
+
+    return 0;
+}
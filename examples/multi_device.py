@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+
+# Drives several devices from one process, each updated by its own thread.
+# Uses the connected sensors, or simulated devices if there are none:
+#
+#   python multi_device.py            # all connected sensors
+#   python multi_device.py sim:30:2 sim:15:1
+
+import sys
+sys.path.insert(1, '../build')
+
+from pynuitrack import Nuitrack, get_devices
+from time import sleep, time
+
+SECONDS = 5
+
+specs = sys.argv[1:]
+if not specs:
+    specs = [device["serial"] for device in get_devices()]
+if not specs:
+    specs = ["sim:30:2", "sim:30:1", "sim:15:3"]
+
+counters = {}
+
+def makeSkeletonCallback(name):
+    def skelCallback(data):
+        counters[name] += 1
+    return skelCallback
+
+devices = []
+for spec in specs:
+    nt = Nuitrack()
+    nt.init("", spec)
+    name = "%d: %s" % (len(devices), nt.get_device_name())
+    counters[name] = 0
+    nt.set_skeleton_callback(makeSkeletonCallback(name))
+    devices.append(nt)
+
+start = time()
+for nt in devices:
+    nt.start()
+
+sleep(SECONDS)
+
+for nt in devices:
+    nt.stop()
+elapsed = time() - start
+
+for name, count in counters.items():
+    print("%-40s %6.1f skeleton frames/s" % (name, count / elapsed))
+
+for nt in devices:
+    nt.release()
@@ -0,0 +1,49 @@
+#!/usr/bin/env python
+
+# Keeps tracking through sensor failures with the watchdog. By default, uses
+# a simulated device that stalls 150 updates after each initialization:
+#
+#   python watchdog.py                       # simulated stalls
+#   python watchdog.py sim:30:2:fail=150     # simulated failures
+#   python watchdog.py sim:30:2:hang=150     # simulated blocked updates
+#   python watchdog.py <serial>              # a real sensor (unplug it!)
+#
+# Depth is limited to 5 frames per second. Device timestamps restart after
+# each re-initialization, so the depth rate also checks that rate-limited
+# streams keep flowing across recoveries.
+
+import sys
+sys.path.insert(1, '../build')
+
+from pynuitrack import Nuitrack
+from time import sleep
+
+SECONDS = 20
+
+spec = sys.argv[1] if len(sys.argv) > 1 else "sim:30:2:stall=150"
+
+frames = [0]
+def on_skeletons(data):
+    frames[0] += 1
+
+nt = Nuitrack()
+nt.init("", spec)
+nt.set_skeleton_callback(on_skeletons)
+nt.set_depth_callback(lambda data: None, rate=5)
+nt.set_watchdog(timeout=1.0)
+nt.start()
+
+depth = 0
+for _ in range(SECONDS):
+    sleep(1)
+    stats = nt.get_watchdog_stats()
+    delivered = nt.get_stream_stats()["depth"].delivered
+    print("%5d frames  %d depth/s  %d failures  %d stalls  %d hangs  "
+          "%d recoveries  last %.1f ms  max %.1f ms" % (
+              frames[0], delivered - depth, stats["failures"],
+              stats["stalls"], stats["hangs"], stats["recoveries"],
+              stats["last_recovery_ms"], stats["max_recovery_ms"]))
+    depth = delivered
+
+nt.stop()
+nt.release()
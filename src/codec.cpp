@@ -0,0 +1,927 @@
+/**
+ * @file codec.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the lossless codec for depth and user label images.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "codec.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CODEC_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CODEC_NEON
+#endif
+
+/// Number of residuals sharing a bit width.
+static const size_t BLOCK = 32;
+
+/// Size of the frame header: magic (2), version, flags, rows, cols.
+static const size_t HEADER_SIZE = 12;
+
+/// Zero bytes appended to depth frames, so blocks can be read 8 bytes at a
+/// time without bound checks.
+static const size_t PADDING = 8;
+
+/// Format version written in the header.
+static const uint8_t VERSION = 1;
+
+/// Header flag of the depth frames coded through a palette.
+static const uint8_t FLAG_PALETTE = 1;
+
+/// The palette is used when the frame has at least this many pixels per
+/// distinct value.
+static const size_t PALETTE_DENSITY = 16;
+
+/// Magic numbers of the depth and label frames.
+static const char DEPTH_MAGIC[2] = {'N', 'D'};
+static const char LABEL_MAGIC[2] = {'N', 'L'};
+
+// Multi-byte values are stored little-endian, as in memory on every platform
+// supported by Nuitrack.
+
+static inline void store32(uint8_t *dst, uint32_t value)
+{
+    std::memcpy(dst, &value, 4);
+}
+
+static inline uint32_t load32(const uint8_t *src)
+{
+    uint32_t value;
+    std::memcpy(&value, src, 4);
+    return value;
+}
+
+static inline uint64_t load64(const uint8_t *src)
+{
+    uint64_t value;
+    std::memcpy(&value, src, 8);
+    return value;
+}
+
+/**
+ * @brief Writes the frame header.
+ */
+static void writeHeader(const char *magic, int rows, int cols,
+                        std::vector<uint8_t> &out)
+{
+    out.resize(HEADER_SIZE);
+    out[0] = magic[0];
+    out[1] = magic[1];
+    out[2] = VERSION;
+    out[3] = 0;
+    store32(&out[4], (uint32_t)rows);
+    store32(&out[8], (uint32_t)cols);
+}
+
+/**
+ * @brief Appends an unsigned LEB128 integer.
+ */
+static inline uint8_t *putVarint(uint8_t *dst, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        *dst++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *dst++ = (uint8_t)value;
+    return dst;
+}
+
+/**
+ * @brief Reads an unsigned LEB128 integer. Returns NULL if truncated.
+ */
+static inline const uint8_t *getVarint(const uint8_t *src, const uint8_t *end,
+                                       uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && src < end; shift += 7)
+    {
+        uint8_t byte = *src++;
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return src;
+    }
+    return NULL;
+}
+
+/// Number of bits needed by each byte value.
+static const struct WidthTable
+{
+    uint8_t bits[256];
+    WidthTable()
+    {
+        for (int v = 0; v < 256; v++)
+        {
+            bits[v] = 0;
+            while (v >> bits[v])
+                bits[v]++;
+        }
+    }
+} widthTable;
+
+/**
+ * @brief Number of bits needed by a value.
+ */
+static inline int bitWidth(uint16_t value)
+{
+    return value >> 8 ? 8 + widthTable.bits[value >> 8] : widthTable.bits[value];
+}
+
+/**
+ * @brief Zigzag coding: maps small negative and positive residuals to small
+ *      unsigned values.
+ */
+static inline uint16_t zigzag(uint16_t r)
+{
+    return (uint16_t)((r << 1) ^ (0u - (r >> 15)));
+}
+
+/**
+ * @brief Predictors available for each depth row.
+ */
+enum Predictor
+{
+    /// Left neighbor. Best on noisy data.
+    PREDICT_LEFT,
+
+    /// Upper neighbor.
+    PREDICT_UP,
+
+    /// Left + up - upper-left. Best on smooth surfaces.
+    PREDICT_GRADIENT
+};
+
+#if defined(CODEC_SSE2)
+/**
+ * @brief Adds min(zigzag(d), 256) of 8 residuals to 4 32-bit sums.
+ */
+static inline __m128i addCost(__m128i sum, __m128i d)
+{
+    __m128i z = _mm_xor_si128(_mm_slli_epi16(d, 1), _mm_srai_epi16(d, 15));
+    z = _mm_sub_epi16(z, _mm_subs_epu16(z, _mm_set1_epi16(256)));
+    return _mm_add_epi32(sum, _mm_madd_epi16(z, _mm_set1_epi16(1)));
+}
+#elif defined(CODEC_NEON)
+static inline uint32x4_t addCost(uint32x4_t sum, uint16x8_t d)
+{
+    uint16x8_t sign =
+        vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(d), 15));
+    uint16x8_t z = veorq_u16(vshlq_n_u16(d, 1), sign);
+    return vpadalq_u16(sum, vminq_u16(z, vdupq_n_u16(256)));
+}
+#endif
+
+/**
+ * @brief Chooses the predictor with the smallest residuals for a row.
+ *
+ * Residuals are saturated, so that a few edges or holes (which are coded as
+ * exceptions anyway) do not decide the predictor.
+ */
+static Predictor choosePredictor(const uint16_t *row, const uint16_t *up,
+                                 int cols)
+{
+    uint32_t left = 0, vertical = 0, gradient = 0;
+    int c = 1;
+#if defined(CODEC_SSE2)
+    __m128i sumL = _mm_setzero_si128();
+    __m128i sumU = sumL, sumG = sumL;
+    for (; c + 8 <= cols; c += 8)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(row + c));
+        __m128i xl = _mm_loadu_si128((const __m128i *)(row + c - 1));
+        __m128i u = _mm_loadu_si128((const __m128i *)(up + c));
+        __m128i ul = _mm_loadu_si128((const __m128i *)(up + c - 1));
+        __m128i dl = _mm_sub_epi16(x, xl);
+        __m128i du = _mm_sub_epi16(x, u);
+        __m128i dg = _mm_sub_epi16(dl, _mm_sub_epi16(u, ul));
+
+        sumL = addCost(sumL, dl);
+        sumU = addCost(sumU, du);
+        sumG = addCost(sumG, dg);
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, sumL);
+    left = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_si128((__m128i *)lanes, sumU);
+    vertical = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_si128((__m128i *)lanes, sumG);
+    gradient = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(CODEC_NEON)
+    uint32x4_t sumL = vdupq_n_u32(0);
+    uint32x4_t sumU = sumL, sumG = sumL;
+    for (; c + 8 <= cols; c += 8)
+    {
+        uint16x8_t x = vld1q_u16(row + c);
+        uint16x8_t u = vld1q_u16(up + c);
+        uint16x8_t dl = vsubq_u16(x, vld1q_u16(row + c - 1));
+        uint16x8_t du = vsubq_u16(x, u);
+        uint16x8_t dg = vsubq_u16(dl, vsubq_u16(u, vld1q_u16(up + c - 1)));
+
+        sumL = addCost(sumL, dl);
+        sumU = addCost(sumU, du);
+        sumG = addCost(sumG, dg);
+    }
+    uint32_t lanes[4];
+    vst1q_u32(lanes, sumL);
+    left = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_u32(lanes, sumU);
+    vertical = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_u32(lanes, sumG);
+    gradient = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; c < cols; c++)
+    {
+        uint16_t dl = (uint16_t)(row[c] - row[c - 1]);
+        uint16_t du = (uint16_t)(row[c] - up[c]);
+        uint16_t dg = (uint16_t)(dl - up[c] + up[c - 1]);
+        left += std::min<uint16_t>(zigzag(dl), 256);
+        vertical += std::min<uint16_t>(zigzag(du), 256);
+        gradient += std::min<uint16_t>(zigzag(dg), 256);
+    }
+
+    if (gradient <= left && gradient <= vertical)
+        return PREDICT_GRADIENT;
+    return left <= vertical ? PREDICT_LEFT : PREDICT_UP;
+}
+
+/**
+ * @brief Computes the zigzag residuals of a depth row.
+ *
+ * @param row Depth row.
+ * @param up Row above (unused by PREDICT_LEFT).
+ * @param cols Number of columns.
+ * @param predictor Predictor of the row.
+ * @param[out] residual Zigzag residuals.
+ */
+static void predictRow(const uint16_t *row, const uint16_t *up, int cols,
+                       Predictor predictor, uint16_t *residual)
+{
+    // All arithmetic is modulo 2^16, which keeps the coding lossless.
+    switch (predictor)
+    {
+    case PREDICT_LEFT:
+        residual[0] = zigzag(row[0]);
+        for (int c = 1; c < cols; c++)
+            residual[c] = zigzag((uint16_t)(row[c] - row[c - 1]));
+        break;
+
+    case PREDICT_UP:
+        for (int c = 0; c < cols; c++)
+            residual[c] = zigzag((uint16_t)(row[c] - up[c]));
+        break;
+
+    case PREDICT_GRADIENT:
+        residual[0] = zigzag((uint16_t)(row[0] - up[0]));
+        for (int c = 1; c < cols; c++)
+            residual[c] = zigzag(
+                (uint16_t)(row[c] - row[c - 1] - up[c] + up[c - 1]));
+        break;
+    }
+}
+
+/**
+ * @brief Rebuilds a depth row from its zigzag residuals.
+ *
+ * The left and gradient predictors make each pixel the previous one plus
+ * (residual [+ up - upLeft]), so the row is a prefix sum.
+ *
+ * @param residual Zigzag residuals.
+ * @param up Row above (unused by PREDICT_LEFT).
+ * @param cols Number of columns.
+ * @param predictor Predictor of the row.
+ * @param[out] row Depth row.
+ */
+static void reconstructRow(const uint16_t *residual, const uint16_t *up,
+                           int cols, Predictor predictor, uint16_t *row)
+{
+    bool useUp = predictor != PREDICT_LEFT;
+    bool prefix = predictor != PREDICT_UP;
+    int c = 0;
+#if defined(CODEC_SSE2)
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    __m128i prevUp = zero;
+    for (; c + 8 <= cols; c += 8)
+    {
+        __m128i z = _mm_loadu_si128((const __m128i *)(residual + c));
+        __m128i x = _mm_xor_si128(_mm_srli_epi16(z, 1),
+                                  _mm_sub_epi16(zero, _mm_and_si128(z, one)));
+        if (!prefix)
+        {
+            x = _mm_add_epi16(
+                x, _mm_loadu_si128((const __m128i *)(up + c)));
+            _mm_storeu_si128((__m128i *)(row + c), x);
+            continue;
+        }
+
+        if (useUp)
+        {
+            __m128i u = _mm_loadu_si128((const __m128i *)(up + c));
+            __m128i upLeft = _mm_or_si128(_mm_slli_si128(u, 2),
+                                          _mm_srli_si128(prevUp, 14));
+            x = _mm_add_epi16(x, _mm_sub_epi16(u, upLeft));
+            prevUp = u;
+        }
+
+        // Prefix sum of the 8 lanes, plus the last pixel of the previous
+        // vector.
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi16(x, carry);
+        _mm_storeu_si128((__m128i *)(row + c), x);
+        carry = _mm_shuffle_epi32(_mm_shufflehi_epi16(x, 0xff), 0xff);
+    }
+#elif defined(CODEC_NEON)
+    const uint16x8_t zero = vdupq_n_u16(0);
+    uint16x8_t carry = zero;
+    uint16x8_t prevUp = zero;
+    for (; c + 8 <= cols; c += 8)
+    {
+        uint16x8_t z = vld1q_u16(residual + c);
+        uint16x8_t x = veorq_u16(vshrq_n_u16(z, 1),
+                                 vsubq_u16(zero, vandq_u16(z, vdupq_n_u16(1))));
+        if (!prefix)
+        {
+            vst1q_u16(row + c, vaddq_u16(x, vld1q_u16(up + c)));
+            continue;
+        }
+
+        if (useUp)
+        {
+            uint16x8_t u = vld1q_u16(up + c);
+            uint16x8_t upLeft = vextq_u16(prevUp, u, 7);
+            x = vaddq_u16(x, vsubq_u16(u, upLeft));
+            prevUp = u;
+        }
+
+        x = vaddq_u16(x, vextq_u16(zero, x, 7));
+        x = vaddq_u16(x, vextq_u16(zero, x, 6));
+        x = vaddq_u16(x, vextq_u16(zero, x, 4));
+        x = vaddq_u16(x, carry);
+        vst1q_u16(row + c, x);
+        carry = vdupq_n_u16(vgetq_lane_u16(x, 7));
+    }
+#endif
+
+    uint16_t prev = c ? row[c - 1] : 0;
+    for (; c < cols; c++)
+    {
+        uint16_t z = residual[c];
+        uint16_t x = (uint16_t)((z >> 1) ^ (0u - (z & 1)));
+        if (!prefix)
+        {
+            row[c] = (uint16_t)(x + up[c]);
+            continue;
+        }
+        if (useUp)
+            x = (uint16_t)(x + up[c] - (c ? up[c - 1] : 0));
+        prev = (uint16_t)(prev + x);
+        row[c] = prev;
+    }
+}
+
+// Block header: bits 0-4 hold the width, the others the flags below.
+
+/// The block stores only its nonzero residuals, after a 32-bit mask of their
+/// positions.
+static const uint8_t BLOCK_SPARSE = 0x20;
+
+/// Run of all-zero blocks, whose length (minus one) is in the next byte.
+static const uint8_t BLOCK_ZERO_RUN = 0x40;
+
+/// The block is followed by its exceptions.
+static const uint8_t BLOCK_EXCEPTIONS = 0x80;
+
+/**
+ * @brief Size, in bits, of an exception of a block of the given width.
+ */
+static inline int exceptionBits(int width)
+{
+    // Position byte, plus the high bits rounded up to bytes.
+    return 8 + (width >= 8 ? 8 : 16);
+}
+
+/**
+ * @brief Chooses the packing width of a list of residuals.
+ *
+ * Residuals that do not fit (edges, holes) are stored apart as exceptions,
+ * with their position and high bits.
+ *
+ * @param histogram Number of residuals of each bit width.
+ * @param n Number of residuals.
+ * @param[out] width Width minimizing the size of the list.
+ * @return size_t Size of the list, in bits.
+ */
+static size_t chooseWidth(const int *histogram, size_t n, int &width)
+{
+    // Try all widths, from the widest (no exceptions) down.
+    width = 16;
+    while (width > 0 && !histogram[width])
+        width--;
+    size_t bestCost = n * width;
+    int exceptions = 0;
+    for (int b = width - 1; b >= 0; b--)
+    {
+        exceptions += histogram[b + 1];
+        size_t cost = n * b + exceptions * exceptionBits(b);
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            width = b;
+        }
+    }
+    return bestCost;
+}
+
+/**
+ * @brief Bit-packs a block of residuals.
+ *
+ * Blocks where most residuals are zero only store the nonzero ones, if that
+ * is smaller.
+ *
+ * @param values Residuals.
+ * @param n Number of residuals (up to BLOCK).
+ * @param dst Output, with room for 2 + 3 * BLOCK bytes.
+ * @return uint8_t* End of the output.
+ */
+static uint8_t *packBlock(const uint16_t *values, size_t n, uint8_t *dst)
+{
+    uint8_t widths[BLOCK];
+    int histogram[17] = {0};
+    for (size_t i = 0; i < n; i++)
+    {
+        widths[i] = (uint8_t)bitWidth(values[i]);
+        histogram[widths[i]]++;
+    }
+
+    int width, sparseWidth;
+    size_t nonzero = n - histogram[0];
+    size_t denseCost = chooseWidth(histogram, n, width);
+    histogram[0] = 0;
+    size_t sparseCost = 32 + chooseWidth(histogram, nonzero, sparseWidth);
+    bool sparse = n == BLOCK && sparseCost < denseCost;
+
+    // Residuals actually packed, and their widths.
+    uint16_t list[BLOCK];
+    uint8_t listWidths[BLOCK];
+    uint32_t mask = 0;
+    size_t length = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (sparse && !values[i])
+            continue;
+        mask |= 1u << i;
+        list[length] = values[i];
+        listWidths[length++] = widths[i];
+    }
+    if (sparse)
+        width = sparseWidth;
+
+    int exceptions = 0;
+    for (size_t i = 0; i < length; i++)
+        exceptions += listWidths[i] > width;
+
+    *dst++ = (uint8_t)(width | (sparse ? BLOCK_SPARSE : 0) |
+                       (exceptions ? BLOCK_EXCEPTIONS : 0));
+    if (exceptions)
+        *dst++ = (uint8_t)exceptions;
+    if (sparse)
+    {
+        store32(dst, mask);
+        dst += 4;
+    }
+
+    if (width)
+    {
+        uint16_t bits = (uint16_t)((1u << width) - 1);
+        uint64_t acc = 0;
+        int used = 0;
+        for (size_t i = 0; i < length; i++)
+        {
+            acc |= (uint64_t)(list[i] & bits) << used;
+            used += width;
+            if (used >= 32)
+            {
+                store32(dst, (uint32_t)acc);
+                dst += 4;
+                acc >>= 32;
+                used -= 32;
+            }
+        }
+        for (; used > 0; used -= 8)
+        {
+            *dst++ = (uint8_t)acc;
+            acc >>= 8;
+        }
+    }
+
+    for (size_t i = 0; exceptions && i < length; i++)
+    {
+        if (listWidths[i] <= width)
+            continue;
+
+        uint16_t high = (uint16_t)(list[i] >> width);
+        *dst++ = (uint8_t)i;
+        *dst++ = (uint8_t)high;
+        if (width < 8)
+            *dst++ = (uint8_t)(high >> 8);
+    }
+    return dst;
+}
+
+/**
+ * @brief Unpacks a block written by packBlock().
+ *
+ * @param src Block, followed by at least PADDING readable bytes.
+ * @param end End of the blocks.
+ * @param n Number of residuals.
+ * @param[out] values Residuals.
+ * @return const uint8_t* End of the block, or NULL if it is invalid.
+ */
+static const uint8_t *unpackBlock(const uint8_t *src, const uint8_t *end,
+                                  size_t n, uint16_t *values)
+{
+    uint8_t header = *src++;
+    int width = header & 0x1f;
+    int exceptions = 0;
+    uint32_t mask = 0;
+    size_t length = n;
+    if (header & BLOCK_EXCEPTIONS)
+    {
+        if (src >= end)
+            return NULL;
+        exceptions = *src++;
+    }
+    if (header & BLOCK_SPARSE)
+    {
+        if (n != BLOCK || end - src < 4)
+            return NULL;
+        mask = load32(src);
+        src += 4;
+        length = 0;
+        for (uint32_t m = mask; m; m &= m - 1)
+            length++;
+    }
+
+    size_t bytes = (length * width + 7) / 8;
+    size_t excBytes = exceptions * (width < 8 ? 3 : 2);
+    if (width > 16 || exceptions > (int)length ||
+        bytes + excBytes > (size_t)(end - src))
+        return NULL;
+
+    if (!width)
+        std::fill(values, values + length, 0);
+    else
+    {
+        // The padding makes the 8-byte reads safe up to the last block.
+        uint64_t bits = (1u << width) - 1;
+        for (size_t i = 0; i < length; i++)
+        {
+            size_t bit = i * width;
+            values[i] = (uint16_t)((load64(src + (bit >> 3)) >> (bit & 7)) &
+                                   bits);
+        }
+        src += bytes;
+    }
+
+    for (int k = 0; k < exceptions; k++)
+    {
+        size_t i = *src++;
+        uint16_t high = *src++;
+        if (width < 8)
+            high |= (uint16_t)(*src++ << 8);
+        if (i >= length)
+            return NULL;
+        values[i] |= (uint16_t)(high << width);
+    }
+
+    if (header & BLOCK_SPARSE)
+    {
+        // Moves the nonzero residuals to their positions, from the end so
+        // that none is overwritten.
+        size_t j = length;
+        for (size_t i = n; i-- > 0;)
+            values[i] = (mask >> i) & 1 ? values[--j] : 0;
+    }
+    return src;
+}
+
+/**
+ * @brief Counts the all-zero blocks starting at the given residual.
+ *
+ * @param values Residuals.
+ * @param count Number of residuals left.
+ * @return size_t Number of whole zero blocks, up to 256.
+ */
+static size_t zeroBlocks(const uint16_t *values, size_t count)
+{
+    size_t blocks = 0;
+    for (; blocks < 256 && (blocks + 1) * BLOCK <= count; blocks++)
+    {
+        uint16_t any = 0;
+        for (size_t i = 0; i < BLOCK; i++)
+            any |= values[blocks * BLOCK + i];
+        if (any)
+            break;
+    }
+    return blocks;
+}
+
+void FrameCodec::_buildPalette(const uint16_t *depth, size_t count)
+{
+    _index.assign(1 << 16, 0);
+    for (size_t i = 0; i < count; i++)
+        _index[depth[i]] = 1;
+
+    _palette.clear();
+    for (size_t value = 0; value < _index.size(); value++)
+        if (_index[value])
+        {
+            _index[value] = (uint16_t)_palette.size();
+            _palette.push_back((uint16_t)value);
+        }
+}
+
+void FrameCodec::compressDepth(const uint16_t *depth, int rows, int cols,
+                               std::vector<uint8_t> &out)
+{
+    size_t count = (size_t)rows * cols;
+    size_t blocks = (count + BLOCK - 1) / BLOCK;
+    _buildPalette(depth, count);
+    // Empty frames have no palette, as a palette is never empty.
+    bool palette = count && _palette.size() * PALETTE_DENSITY <= count;
+
+    writeHeader(DEPTH_MAGIC, rows, cols, out);
+    out.resize(HEADER_SIZE + (palette ? 3 * (_palette.size() + 1) : 0) +
+               rows + blocks * (2 + 3 * BLOCK) + PADDING);
+    uint8_t *dst = &out[HEADER_SIZE];
+
+    if (palette)
+    {
+        // Values are stored as their (positive) differences.
+        out[3] = FLAG_PALETTE;
+        dst = putVarint(dst, (uint32_t)_palette.size());
+        uint32_t previous = 0;
+        for (size_t i = 0; i < _palette.size(); i++)
+        {
+            dst = putVarint(dst, i ? _palette[i] - previous - 1 : _palette[i]);
+            previous = _palette[i];
+        }
+
+        _mapped.resize(count);
+        for (size_t i = 0; i < count; i++)
+            _mapped[i] = _index[depth[i]];
+        depth = _mapped.data();
+    }
+
+    // The predictor of each row is stored before the blocks.
+    // Empty frames (no rows or no columns) only store left predictors.
+    uint8_t *predictors = dst;
+    std::memset(predictors, PREDICT_LEFT, rows);
+    dst += rows;
+    _residual.resize(count);
+    for (int r = 0; count && r < rows; r++)
+    {
+        const uint16_t *row = depth + (size_t)r * cols;
+        const uint16_t *up = r ? row - cols : NULL;
+        Predictor predictor = up ? choosePredictor(row, up, cols)
+                                 : PREDICT_LEFT;
+        predictors[r] = (uint8_t)predictor;
+        predictRow(row, up, cols, predictor, &_residual[(size_t)r * cols]);
+    }
+
+    for (size_t begin = 0; begin < count;)
+    {
+        size_t zeros = zeroBlocks(&_residual[begin], count - begin);
+        if (zeros > 1)
+        {
+            *dst++ = BLOCK_ZERO_RUN;
+            *dst++ = (uint8_t)(zeros - 1);
+            begin += zeros * BLOCK;
+            continue;
+        }
+
+        size_t n = std::min(BLOCK, count - begin);
+        dst = packBlock(&_residual[begin], n, dst);
+        begin += n;
+    }
+
+    std::memset(dst, 0, PADDING);
+    out.resize(dst + PADDING - &out[0]);
+}
+
+void FrameCodec::compressLabels(const uint16_t *labels, int rows, int cols,
+                                std::vector<uint8_t> &out)
+{
+    size_t count = (size_t)rows * cols;
+    writeHeader(LABEL_MAGIC, rows, cols, out);
+
+    // Runs are written as (length - 1, value) pairs, up to 8 bytes each.
+    size_t capacity = HEADER_SIZE + 64;
+    out.resize(capacity);
+    size_t used = HEADER_SIZE;
+
+    size_t i = 0;
+    while (i < count)
+    {
+        uint16_t value = labels[i];
+        size_t end = i + 1;
+#if defined(CODEC_SSE2)
+        __m128i v = _mm_set1_epi16((short)value);
+        while (end + 8 <= count)
+        {
+            __m128i eq = _mm_cmpeq_epi16(
+                _mm_loadu_si128((const __m128i *)(labels + end)), v);
+            if (_mm_movemask_epi8(eq) != 0xffff)
+                break;
+            end += 8;
+        }
+#elif defined(CODEC_NEON)
+        uint16x8_t v = vdupq_n_u16(value);
+        while (end + 8 <= count)
+        {
+            uint16x8_t eq = vceqq_u16(vld1q_u16(labels + end), v);
+            uint64x2_t halves = vreinterpretq_u64_u16(eq);
+            if (vgetq_lane_u64(halves, 0) != ~0ull ||
+                vgetq_lane_u64(halves, 1) != ~0ull)
+                break;
+            end += 8;
+        }
+#endif
+        // The scalar loop finds where the run ends within the last vector.
+        while (end < count && labels[end] == value)
+            end++;
+
+        if (used + 16 > capacity)
+        {
+            capacity *= 2;
+            out.resize(capacity);
+        }
+        uint8_t *dst = &out[used];
+        dst = putVarint(dst, (uint32_t)(end - i - 1));
+        dst = putVarint(dst, value);
+        used = dst - &out[0];
+        i = end;
+    }
+
+    out.resize(used);
+}
+
+bool FrameCodec::decompress(const uint8_t *data, size_t size,
+                            std::vector<uint16_t> &out, int &rows, int &cols)
+{
+    if (size < HEADER_SIZE || data[2] != VERSION)
+        return false;
+
+    bool depth = data[0] == DEPTH_MAGIC[0] && data[1] == DEPTH_MAGIC[1];
+    bool labels = data[0] == LABEL_MAGIC[0] && data[1] == LABEL_MAGIC[1];
+    uint32_t nRows = load32(data + 4);
+    uint32_t nCols = load32(data + 8);
+    // Refuse sizes no sensor produces, rather than allocating them.
+    if ((!depth && !labels) || nRows > 1 << 14 || nCols > 1 << 14 ||
+        (data[3] & ~(depth ? FLAG_PALETTE : 0)))
+        return false;
+
+    rows = (int)nRows;
+    cols = (int)nCols;
+    size_t count = (size_t)rows * cols;
+    out.resize(count);
+    const uint8_t *src = data + HEADER_SIZE;
+
+    if (labels)
+    {
+        const uint8_t *end = data + size;
+        size_t i = 0;
+        while (i < count)
+        {
+            uint32_t length, value;
+            src = getVarint(src, end, length);
+            if (!src)
+                return false;
+            src = getVarint(src, end, value);
+            if (!src || length >= count - i || value > 0xffff)
+                return false;
+
+            std::fill(out.begin() + i, out.begin() + i + length + 1,
+                      (uint16_t)value);
+            i += length + 1;
+        }
+        return src == end;
+    }
+
+    if (size < HEADER_SIZE + PADDING)
+        return false;
+    const uint8_t *end = data + size - PADDING;
+
+    if (data[3] & FLAG_PALETTE)
+    {
+        uint32_t length, value = 0;
+        src = getVarint(src, end, length);
+        if (!src || !length || length > 1 << 16)
+            return false;
+
+        _palette.resize(length);
+        for (uint32_t i = 0; i < length; i++)
+        {
+            uint32_t delta;
+            src = getVarint(src, end, delta);
+            value += i ? delta + 1 : delta;
+            if (!src || value > 0xffff)
+                return false;
+            _palette[i] = (uint16_t)value;
+        }
+    }
+
+    if (rows > end - src)
+        return false;
+    const uint8_t *predictors = src;
+    for (int r = 0; r < rows; r++)
+        if (predictors[r] > PREDICT_GRADIENT || (!r && predictors[r]))
+            return false;
+    src += rows;
+
+    _residual.resize(count);
+    for (size_t begin = 0; begin < count;)
+    {
+        if (src >= end)
+            return false;
+
+        if (*src & BLOCK_ZERO_RUN)
+        {
+            size_t blocks = (size_t)src[1] + 1;
+            if (*src != BLOCK_ZERO_RUN || end - src < 2 ||
+                blocks * BLOCK > count - begin)
+                return false;
+            std::fill(&_residual[begin], &_residual[begin] + blocks * BLOCK,
+                      0);
+            begin += blocks * BLOCK;
+            src += 2;
+            continue;
+        }
+
+        size_t n = std::min(BLOCK, count - begin);
+        src = unpackBlock(src, end, n, &_residual[begin]);
+        if (!src)
+            return false;
+        begin += n;
+    }
+    if (src != end)
+        return false;
+
+    for (int r = 0; count && r < rows; r++)
+        reconstructRow(&_residual[(size_t)r * cols],
+                       r ? &out[(size_t)(r - 1) * cols] : NULL, cols,
+                       (Predictor)predictors[r], &out[(size_t)r * cols]);
+
+    if (data[3] & FLAG_PALETTE)
+    {
+        // Indices past the palette are clamped while mapping, and reported
+        // after it.
+        uint16_t *pixels = out.data();
+        const uint16_t *palette = _palette.data();
+        uint16_t last = (uint16_t)(_palette.size() - 1);
+        bool invalid = false;
+        for (size_t i = 0; i < count; i++)
+        {
+            invalid |= pixels[i] > last;
+            pixels[i] = palette[std::min(pixels[i], last)];
+        }
+        if (invalid)
+            return false;
+    }
+    return true;
+}
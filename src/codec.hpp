@@ -0,0 +1,123 @@
+/**
+ * @file codec.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the lossless codec for depth and user label images.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef codec_H
+#define codec_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Lossless compression of depth and user label images.
+ *
+ * Each depth row is predicted from its left neighbor, its upper neighbor
+ * or both (p = left + up - upLeft), whichever leaves the smallest residuals.
+ * Residuals are zigzag coded and bit-packed in blocks of 32, each block
+ * using the width that minimizes its size; the few residuals that do not
+ * fit (object edges, holes) are stored apart as exceptions. Decoding turns
+ * the prediction into a prefix sum along the row, which is done with SIMD.
+ *
+ * Sensors quantize depth (the step grows with the distance), so a frame
+ * usually holds a few hundred distinct values. When that is the case, the
+ * sorted list of values is stored and pixels are coded by their index in
+ * it, which turns each step into a residual of one.
+ *
+ * Label images are run-length coded, as they are made of a few large
+ * regions of constant value.
+ *
+ * Compressed frames start with a small header identifying their kind and
+ * size, so decompress() handles both.
+ */
+class FrameCodec
+{
+private:
+    /// Zigzag residuals of the frame being coded.
+    std::vector<uint16_t> _residual;
+
+    /// Sorted distinct values of the depth frame being coded.
+    std::vector<uint16_t> _palette;
+
+    /// Index in the palette of each depth value.
+    std::vector<uint16_t> _index;
+
+    /// Depth frame mapped to palette indices.
+    std::vector<uint16_t> _mapped;
+
+    /**
+     * @brief Fills the palette and the index table of a depth frame.
+     *
+     * @param depth Depth image.
+     * @param count Number of pixels.
+     */
+    void _buildPalette(const uint16_t *depth, size_t count);
+
+public:
+    /**
+     * @brief Compresses a depth image.
+     *
+     * @param depth Depth image, in millimeters.
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     * @param[out] out Compressed frame.
+     */
+    void compressDepth(const uint16_t *depth, int rows, int cols,
+                       std::vector<uint8_t> &out);
+
+    /**
+     * @brief Compresses a user label image.
+     *
+     * @param labels Label image (0 for background).
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     * @param[out] out Compressed frame.
+     */
+    void compressLabels(const uint16_t *labels, int rows, int cols,
+                        std::vector<uint8_t> &out);
+
+    /**
+     * @brief Decompresses a frame produced by compressDepth() or
+     *      compressLabels().
+     *
+     * @param data Compressed frame.
+     * @param size Size of the compressed frame, in bytes.
+     * @param[out] out Decompressed image.
+     * @param[out] rows Number of rows.
+     * @param[out] cols Number of columns.
+     * @return true if the frame is valid.
+     */
+    bool decompress(const uint8_t *data, size_t size,
+                    std::vector<uint16_t> &out, int &rows, int &cols);
+};
+
+#endif
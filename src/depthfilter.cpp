@@ -0,0 +1,316 @@
+/**
+ * @file depthfilter.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the DepthFilter class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "depthfilter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+/// Minimum number of rows handed to each thread.
+static const size_t ROW_GRAIN = 16;
+
+/**
+ * @brief Median of three values, using only min/max.
+ */
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+/**
+ * @brief Median of five values, using only min/max.
+ */
+static inline uint16_t median5(uint16_t a, uint16_t b, uint16_t c,
+                               uint16_t d, uint16_t e)
+{
+    uint16_t f = std::max(std::min(a, b), std::min(c, d));
+    uint16_t g = std::min(std::max(a, b), std::max(c, d));
+    return median3(e, f, g);
+}
+
+/**
+ * @brief Adds a neighbour to the range-gated mean if it is close enough.
+ */
+static inline void gate(int n, int center, int threshold, int &sum, int &count)
+{
+    int near = (n != 0) & (std::abs(n - center) <= threshold);
+    sum += near * n;
+    count += near;
+}
+
+/**
+ * @brief Range-gated 3x3 mean of the pixel in column `j`.
+ *
+ * @param rows Pointers to the rows above, at and below the pixel.
+ * @param jl Column to the left (clamped at the border).
+ * @param j Column of the pixel.
+ * @param jr Column to the right (clamped at the border).
+ * @param threshold Largest depth difference averaged with the center.
+ */
+static inline uint16_t edgePixel(const uint16_t *const rows[3], int jl, int j,
+                                 int jr, int threshold)
+{
+    int center = rows[1][j];
+    int sum = 0, count = 0;
+    gate(rows[0][jl], center, threshold, sum, count);
+    gate(rows[0][j], center, threshold, sum, count);
+    gate(rows[0][jr], center, threshold, sum, count);
+    gate(rows[1][jl], center, threshold, sum, count);
+    gate(center, center, threshold, sum, count);
+    gate(rows[1][jr], center, threshold, sum, count);
+    gate(rows[2][jl], center, threshold, sum, count);
+    gate(rows[2][j], center, threshold, sum, count);
+    gate(rows[2][jr], center, threshold, sum, count);
+
+    // The center always counts when it is valid, so count is only zero when
+    // the result is discarded. Kept branchless so the loop is vectorized.
+    count += count == 0;
+    int mean = (int)((float)sum / (float)count + 0.5f);
+    return (uint16_t)(mean * (center != 0));
+}
+
+DepthFilter::DepthFilter(ThreadPool *pool)
+    : _pool(pool), _rows(0), _cols(0), _medianSlot(0), _frames(0)
+{
+    _passMs[0] = _passMs[1] = 0;
+}
+
+void DepthFilter::configure(const DepthFilterConfig &config)
+{
+    _config = config;
+    if (_config.medianWindow != 5)
+        _config.medianWindow = 3;
+    reset();
+}
+
+const DepthFilterConfig &DepthFilter::config() const
+{
+    return _config;
+}
+
+bool DepthFilter::enabled() const
+{
+    return _config.holeFill > 0 || _config.temporal != TEMPORAL_NONE ||
+           _config.edgeThreshold > 0;
+}
+
+void DepthFilter::reset()
+{
+    _rows = _cols = 0;
+    _ema.clear();
+    _median.clear();
+    _pass.clear();
+    _medianSlot = 0;
+    _frames = 0;
+    _passMs[0] = _passMs[1] = 0;
+}
+
+void DepthFilter::_resize(int rows, int cols)
+{
+    size_t pixels = (size_t)rows * cols;
+    _rows = rows;
+    _cols = cols;
+    _ema.assign(_config.temporal == TEMPORAL_EMA ? pixels : 0, 0.0f);
+    _median.assign(_config.temporal == TEMPORAL_MEDIAN ?
+                   pixels * _config.medianWindow : 0, 0);
+    _pass.assign(_config.edgeThreshold > 0 ? pixels : 0, 0);
+    _medianSlot = 0;
+}
+
+void DepthFilter::_firstPass(const uint16_t *in, uint16_t *out, size_t begin,
+                             size_t end, bool seed)
+{
+    const size_t cols = _cols;
+    const size_t pixels = (size_t)_rows * _cols;
+
+    for (size_t r = begin; r < end; r++)
+    {
+        uint16_t *dst = out + r * cols;
+        std::memcpy(dst, in + r * cols, cols * sizeof(uint16_t));
+
+        // Fill short runs of zeros with the farthest of their two borders,
+        // so foreground objects do not bleed into the background.
+        if (_config.holeFill > 0)
+        {
+            size_t j = 0;
+            while (j < cols)
+            {
+                if (dst[j])
+                {
+                    j++;
+                    continue;
+                }
+
+                size_t k = j;
+                while (k < cols && !dst[k])
+                    k++;
+
+                if (j > 0 && k < cols && k - j <= (size_t)_config.holeFill)
+                    std::fill(dst + j, dst + k, std::max(dst[j - 1], dst[k]));
+                j = k;
+            }
+        }
+
+        if (_config.temporal == TEMPORAL_EMA)
+        {
+            float *state = &_ema[r * cols];
+            const float alpha = _config.alpha;
+            const float delta = (float)_config.temporalDelta;
+            for (size_t j = 0; j < cols; j++)
+            {
+                float d = dst[j];
+                float s = state[j];
+                // Restart on new data or large jumps, so motion is not
+                // smeared. Pixels without data keep their state.
+                float jump = (float)((s == 0) | (std::fabs(d - s) > delta));
+                float valid = (float)(d != 0);
+                float next = s + (alpha + jump * (1 - alpha)) * (d - s);
+                state[j] = s + valid * (next - s);
+                dst[j] = (uint16_t)(valid * next + 0.5f);
+            }
+        }
+        else if (_config.temporal == TEMPORAL_MEDIAN)
+        {
+            const int window = _config.medianWindow;
+            uint16_t *history = &_median[r * cols];
+            for (int k = 0; k < window; k++)
+                if (seed || k == _medianSlot)
+                    std::memcpy(history + k * pixels, dst,
+                                cols * sizeof(uint16_t));
+
+            const uint16_t *h0 = history;
+            const uint16_t *h1 = h0 + pixels;
+            const uint16_t *h2 = h1 + pixels;
+            if (window == 3)
+            {
+                for (size_t j = 0; j < cols; j++)
+                    dst[j] = median3(h0[j], h1[j], h2[j]);
+            }
+            else
+            {
+                const uint16_t *h3 = h2 + pixels;
+                const uint16_t *h4 = h3 + pixels;
+                for (size_t j = 0; j < cols; j++)
+                    dst[j] = median5(h0[j], h1[j], h2[j], h3[j], h4[j]);
+            }
+        }
+    }
+}
+
+void DepthFilter::_edgePass(const uint16_t *in, uint16_t *out, size_t begin,
+                            size_t end) const
+{
+    const int cols = _cols;
+    const int threshold = _config.edgeThreshold;
+
+    for (size_t r = begin; r < end; r++)
+    {
+        const uint16_t *rows[3] = {
+            in + (r > 0 ? r - 1 : r) * cols,
+            in + r * cols,
+            in + (r + 1 < (size_t)_rows ? r + 1 : r) * cols};
+        uint16_t *dst = out + r * cols;
+
+        if (cols < 2)
+        {
+            if (cols)
+                dst[0] = edgePixel(rows, 0, 0, 0, threshold);
+            continue;
+        }
+
+        dst[0] = edgePixel(rows, 0, 0, 1, threshold);
+        for (int j = 1; j < cols - 1; j++)
+            dst[j] = edgePixel(rows, j - 1, j, j + 1, threshold);
+        dst[cols - 1] = edgePixel(rows, cols - 2, cols - 1, cols - 1,
+                                  threshold);
+    }
+}
+
+void DepthFilter::apply(const uint16_t *in, uint16_t *out, int rows, int cols)
+{
+    typedef std::chrono::steady_clock clock;
+
+    bool seed = rows != _rows || cols != _cols;
+    if (seed)
+        _resize(rows, cols);
+
+    bool edge = _config.edgeThreshold > 0;
+    uint16_t *first = edge ? _pass.data() : out;
+
+    clock::time_point t0 = clock::now();
+    if (_config.holeFill > 0 || _config.temporal != TEMPORAL_NONE)
+    {
+        std::function<void(size_t, size_t)> body = [&](size_t b, size_t e)
+        {
+            _firstPass(in, first, b, e, seed);
+        };
+        if (_pool)
+            _pool->parallelFor(rows, body, ROW_GRAIN);
+        else
+            body(0, rows);
+    }
+    else
+        std::memcpy(first, in, (size_t)rows * cols * sizeof(uint16_t));
+
+    if (_config.temporal == TEMPORAL_MEDIAN)
+        _medianSlot = (_medianSlot + 1) % _config.medianWindow;
+
+    clock::time_point t1 = clock::now();
+    if (edge)
+    {
+        std::function<void(size_t, size_t)> body = [&](size_t b, size_t e)
+        {
+            _edgePass(first, out, b, e);
+        };
+        if (_pool)
+            _pool->parallelFor(rows, body, ROW_GRAIN);
+        else
+            body(0, rows);
+    }
+    clock::time_point t2 = clock::now();
+
+    _passMs[0] += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    _passMs[1] += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    _frames++;
+}
+
+uint64_t DepthFilter::frames() const
+{
+    return _frames;
+}
+
+double DepthFilter::passTime(int pass) const
+{
+    return pass >= 0 && pass < 2 ? _passMs[pass] : 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file depthfilter.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the DepthFilter class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef depthfilter_H
+#define depthfilter_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "threadpool.hpp"
+
+/**
+ * @brief Temporal filter modes supported by DepthFilter.
+ */
+enum TemporalFilter
+{
+    TEMPORAL_NONE,
+    TEMPORAL_EMA,
+    TEMPORAL_MEDIAN
+};
+
+/**
+ * @brief Configuration of the DepthFilter stages. Zero disables a stage.
+ */
+struct DepthFilterConfig
+{
+    DepthFilterConfig()
+        : holeFill(0), temporal(TEMPORAL_NONE), alpha(0.4f), medianWindow(3),
+          temporalDelta(100), edgeThreshold(0)
+    {
+    }
+
+    /// Largest run of zero pixels (in a row) filled by the hole filling.
+    int holeFill;
+
+    /// Temporal filter mode.
+    TemporalFilter temporal;
+
+    /// Weight of the new frame in the exponential moving average.
+    float alpha;
+
+    /// Number of frames of the temporal median (3 or 5).
+    int medianWindow;
+
+    /// Depth jump (mm) that resets the moving average of a pixel.
+    int temporalDelta;
+
+    /// Largest depth difference (mm) averaged by the edge-preserving filter.
+    int edgeThreshold;
+};
+
+/**
+ * @brief Cleans depth frames with a configurable chain of filters.
+ *
+ * The chain runs in two passes, both split by rows across a ThreadPool:
+ *  1. hole filling and temporal filtering, fused per row, and
+ *  2. an edge-preserving 3x3 mean that only averages neighbours whose depth
+ *     is within `edgeThreshold` of the center pixel (a bilateral filter with
+ *     box spatial and range kernels).
+ * The temporal and edge-preserving loops are branchless so they are
+ * vectorized by the compiler. Hole filling scans the runs of zeros of each
+ * row, so it is not vectorized, but its cost only grows with the number of
+ * runs.
+ */
+class DepthFilter
+{
+private:
+    /// Current configuration.
+    DepthFilterConfig _config;
+
+    /// Pool used to process rows in parallel (may be NULL).
+    ThreadPool *_pool;
+
+    /// Size of the frames seen so far. A new size resets the state.
+    int _rows, _cols;
+
+    /// Per-pixel moving average.
+    std::vector<float> _ema;
+
+    /// Last `medianWindow` frames, laid out as window x pixels.
+    std::vector<uint16_t> _median;
+
+    /// Slot of `_median` that receives the next frame.
+    int _medianSlot;
+
+    /// Output of the first pass when the edge-preserving filter is enabled.
+    std::vector<uint16_t> _pass;
+
+    /// Number of filtered frames.
+    uint64_t _frames;
+
+    /// Accumulated time spent on each pass, in milliseconds.
+    double _passMs[2];
+
+    /**
+     * @brief Resets the temporal state for frames of the given size.
+     */
+    void _resize(int rows, int cols);
+
+    /**
+     * @brief Runs hole filling and temporal filtering on a range of rows.
+     */
+    void _firstPass(const uint16_t *in, uint16_t *out, size_t begin,
+                    size_t end, bool seed);
+
+    /**
+     * @brief Runs the edge-preserving filter on a range of rows.
+     */
+    void _edgePass(const uint16_t *in, uint16_t *out, size_t begin,
+                   size_t end) const;
+
+public:
+    /**
+     * @brief Construct a new, disabled, DepthFilter object.
+     *
+     * @param pool Pool used to process rows in parallel, or NULL.
+     */
+    DepthFilter(ThreadPool *pool = NULL);
+
+    /**
+     * @brief Sets the filter configuration and resets the temporal state.
+     *
+     * @param config New configuration.
+     */
+    void configure(const DepthFilterConfig &config);
+
+    /**
+     * @brief Returns the current configuration.
+     */
+    const DepthFilterConfig &config() const;
+
+    /**
+     * @brief Returns whether any stage is enabled.
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Discards the temporal state and the statistics.
+     */
+    void reset();
+
+    /**
+     * @brief Filters a depth frame.
+     *
+     * @param in Input depth, in millimeters (0 means no data).
+     * @param out Filtered depth. Must not overlap the input.
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     */
+    void apply(const uint16_t *in, uint16_t *out, int rows, int cols);
+
+    /**
+     * @brief Returns the number of filtered frames.
+     */
+    uint64_t frames() const;
+
+    /**
+     * @brief Returns the time spent on a pass, in milliseconds.
+     *
+     * @param pass 0 for hole filling and temporal filtering, 1 for the
+     *      edge-preserving filter.
+     */
+    double passTime(int pass) const;
+};
+
+#endif
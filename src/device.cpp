@@ -0,0 +1,91 @@
+/**
+ * @file device.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the frame source interface shared by sensors and simulators.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "device.hpp"
+#include "exception.hpp"
+#include "sensordevice.hpp"
+#include "simdevice.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+std::unique_ptr<Device> createDevice(const std::string &spec,
+                                     const std::string &configPath)
+{
+    if (spec != "sim" && spec.compare(0, 4, "sim:") != 0)
+        return std::unique_ptr<Device>(new SensorDevice(spec, configPath));
+
+    // "sim[:fps[:users[:faults]]]", with faults such as "fail=300,stall=500".
+    int fps = 30, users = 1, failAfter = 0, stallAfter = 0, hangAfter = 0;
+    size_t first = spec.find(':');
+    if (first != std::string::npos)
+    {
+        size_t second = spec.find(':', first + 1);
+        fps = std::atoi(spec.substr(first + 1, second - first - 1).c_str());
+        if (second != std::string::npos)
+        {
+            size_t third = spec.find(':', second + 1);
+            users = std::atoi(
+                spec.substr(second + 1, third - second - 1).c_str());
+            if (third != std::string::npos)
+            {
+                std::string faults = spec.substr(third + 1);
+                for (size_t pos = 0; pos < faults.size();)
+                {
+                    size_t end = std::min(faults.find(',', pos), faults.size());
+                    std::string fault = faults.substr(pos, end - pos);
+                    if (fault.compare(0, 5, "fail=") == 0)
+                        failAfter = std::atoi(fault.c_str() + 5);
+                    else if (fault.compare(0, 6, "stall=") == 0)
+                        stallAfter = std::atoi(fault.c_str() + 6);
+                    else if (fault.compare(0, 5, "hang=") == 0)
+                        hangAfter = std::atoi(fault.c_str() + 5);
+                    else
+                        throw NuitrackException(
+                            "Invalid simulated device: " + spec);
+                    pos = end + 1;
+                }
+            }
+        }
+    }
+
+    if (fps < 0 || users < 0 || failAfter < 0 || stallAfter < 0 ||
+        hangAfter < 0)
+        throw NuitrackException("Invalid simulated device: " + spec);
+    return std::unique_ptr<Device>(
+        new SimulatedDevice(fps, users, failAfter, stallAfter, hangAfter));
+}
+
+std::vector<DeviceInfo> listDevices(const std::string &configPath)
+{
+    return SensorDevice::list(configPath);
+}
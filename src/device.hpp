@@ -0,0 +1,172 @@
+/**
+ * @file device.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the frame source interface shared by sensors and simulators.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef device_H
+#define device_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frames.hpp"
+
+/**
+ * @brief Receives the data produced by a Device.
+ *
+ * All methods are called from the thread running Device::update(), and the
+ * frames are only valid during the call.
+ */
+class FrameSink
+{
+public:
+    virtual ~FrameSink() {}
+
+    /// Called with each new depth frame.
+    virtual void onDepthFrame(const DepthImage &frame) = 0;
+
+    /// Called with each new color frame.
+    virtual void onColorFrame(const ColorImage &frame) = 0;
+
+    /// Called with each new user label image.
+    virtual void onUserFrame(const DepthImage &frame) = 0;
+
+    /// Called with each new skeleton tracking result.
+    virtual void onSkeletons(const SkeletonFrame &frame) = 0;
+
+    /// Called with each new hand tracking result.
+    virtual void onHands(const HandFrame &frame) = 0;
+
+    /// Called when built-in gestures are detected.
+    virtual void onGestures(const std::vector<GestureEvent> &gestures) = 0;
+
+    /// Called when tracking issues are reported.
+    virtual void onIssues(const std::vector<IssueEvent> &issues) = 0;
+
+    /// Called when the user tracker finds a user.
+    virtual void onNewUser(int userId) = 0;
+
+    /// Called when the user tracker loses a user.
+    virtual void onLostUser(int userId) = 0;
+};
+
+/**
+ * @brief Identifies a sensor connected to the computer.
+ */
+struct DeviceInfo
+{
+    /// Serial number, used to select the sensor.
+    std::string serial;
+
+    /// Model name.
+    std::string name;
+};
+
+/**
+ * @brief Source of depth, color and tracking data.
+ *
+ * Each Device has its own set of modules and is updated by a single thread,
+ * so several devices can be driven in parallel by the same process.
+ */
+class Device
+{
+public:
+    virtual ~Device() {}
+
+    /**
+     * @brief Creates the modules and starts producing data.
+     *
+     * @param sink Receiver of the data. Must outlive the device.
+     */
+    virtual void init(FrameSink *sink) = 0;
+
+    /**
+     * @brief Waits for the next set of data and feeds it to the sink.
+     */
+    virtual void update() = 0;
+
+    /**
+     * @brief Wakes an update() blocked waiting for data. May be called from
+     *      any thread.
+     * 
+     * @return true if the device supports it, in which case the blocked
+     *      update returns or throws soon after.
+     */
+    virtual bool interrupt() = 0;
+
+    /**
+     * @brief Stops producing data and destroys the modules.
+     */
+    virtual void release() = 0;
+
+    /**
+     * @brief Returns the output mode of the depth stream.
+     */
+    virtual StreamMode depthMode() const = 0;
+
+    /**
+     * @brief Returns the output mode of the color stream.
+     */
+    virtual StreamMode colorMode() const = 0;
+
+    /**
+     * @brief Returns the face tracking data of the latest update, as JSON.
+     */
+    virtual std::string facesJson() = 0;
+
+    /**
+     * @brief Returns a description of the device.
+     */
+    virtual std::string name() const = 0;
+};
+
+/**
+ * @brief Creates a device from its specification.
+ *
+ * @param spec Empty for the default sensor, a sensor serial number, or
+ *      "sim[:fps[:users[:faults]]]" for a simulated device. Faults are a
+ *      comma separated list of "fail=N", "stall=N" and "hang=N" (see
+ *      SimulatedDevice).
+ * @param configPath Path to the Nuitrack configuration file.
+ * @return std::unique_ptr<Device> Device, not initialized yet.
+ */
+std::unique_ptr<Device> createDevice(const std::string &spec,
+                                     const std::string &configPath);
+
+/**
+ * @brief Lists the sensors connected to the computer.
+ *
+ * @param configPath Path to the Nuitrack configuration file.
+ */
+std::vector<DeviceInfo> listDevices(const std::string &configPath);
+
+#endif
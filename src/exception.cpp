@@ -0,0 +1,61 @@
+/**
+ * @file exception.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the NuitrackException classes.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "exception.hpp"
+
+const char *exceptionType_str[] =
+{
+    "OK",
+    "Exception",
+    "Terminated",
+    "Bad configuration value",
+    "Configuration not found",
+    "Module not found",
+    "License not acquired",
+    "Module not initialized",
+    "Module not started"
+};
+
+NuitrackException::NuitrackException(std::string message)
+{
+    this->message = message;
+}
+
+const char *NuitrackException::what() const throw()
+{
+    return this->message.c_str();
+}
+
+NuitrackException::~NuitrackException() throw()
+{
+}
@@ -0,0 +1,82 @@
+/**
+ * @file exception.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the NuitrackException classes.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef exception_H
+#define exception_H
+
+#include <exception>
+#include <string>
+
+/**
+ * @brief General exception class.
+ */
+class NuitrackException : public std::exception
+{
+private:
+    /// Message describing the error.
+    std::string message;
+
+public:
+    /**
+     * @brief Construct a new Nuitrack Exception object.
+     * 
+     * @param message String describing the error.
+     */
+    NuitrackException(std::string message);
+
+    /**
+     * @brief Returns the message with the error description.
+     * 
+     * @return const char* C-string with the error description.
+     */
+    const char *what() const throw();
+
+    /**
+     * @brief Destroy the Nuitrack Exception object.
+     */
+    ~NuitrackException() throw();
+};
+
+/**
+ * @brief Exception used when pynuitrack fails to be initialized.
+ */
+class NuitrackInitFail : public NuitrackException
+{
+};
+
+/**
+ * @brief Translates a Nuitrack error code into a error message.
+ */
+extern const char *exceptionType_str[];
+
+#endif
@@ -0,0 +1,317 @@
+/**
+ * @file floor.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the FloorEstimator class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "floor.hpp"
+#include <algorithm>
+#include <cmath>
+
+/// Number of RANSAC hypotheses per fit.
+static const int RANSAC_ITERATIONS = 200;
+
+/// Largest distance (mm) from a point to the plane to count as inlier.
+static const float INLIER_TOLERANCE = 25.0f;
+
+/// Smallest cosine between the plane normal and the camera's up axis.
+static const float MIN_UP_COSINE = 0.7f;
+
+/// Farthest depth (mm) used, as far points are too noisy.
+static const uint16_t MAX_DEPTH = 6000;
+
+/// Fewest points needed to fit a plane.
+static const size_t MIN_POINTS = 50;
+
+/// Weight of a new fit when it agrees with the previous estimate.
+static const float SMOOTHING = 0.3f;
+
+/**
+ * @brief Counts the points within INLIER_TOLERANCE of the plane.
+ */
+static size_t countInliers(const std::vector<float> &points,
+                           const Plane &plane)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < points.size(); i += 3)
+        count += std::fabs(plane.distance(&points[i])) < INLIER_TOLERANCE;
+    return count;
+}
+
+/**
+ * @brief Least-squares refinement of the plane, using its inliers.
+ *
+ * Solves y = a.x + b.z + c, which is well conditioned as the floor normal is
+ * close to the camera's up axis.
+ */
+static bool refine(const std::vector<float> &points, Plane &plane)
+{
+    double sxx = 0, sxz = 0, szz = 0, sx = 0, sz = 0, n = 0;
+    double sxy = 0, szy = 0, sy = 0;
+    for (size_t i = 0; i < points.size(); i += 3)
+    {
+        const float *p = &points[i];
+        if (std::fabs(plane.distance(p)) >= INLIER_TOLERANCE)
+            continue;
+
+        sxx += p[0] * p[0];
+        sxz += p[0] * p[2];
+        szz += p[2] * p[2];
+        sx += p[0];
+        sz += p[2];
+        n += 1;
+        sxy += p[0] * p[1];
+        szy += p[2] * p[1];
+        sy += p[1];
+    }
+
+    // Cramer's rule on the 3x3 normal equations.
+    double det = sxx * (szz * n - sz * sz) - sxz * (sxz * n - sz * sx) +
+                 sx * (sxz * sz - szz * sx);
+    if (n < 3 || std::fabs(det) < 1e-9)
+        return false;
+
+    double a = (sxy * (szz * n - sz * sz) - sxz * (szy * n - sz * sy) +
+                sx * (szy * sz - szz * sy)) / det;
+    double b = (sxx * (szy * n - sy * sz) - sxy * (sxz * n - sz * sx) +
+                sx * (sxz * sy - szy * sx)) / det;
+    double c = (sxx * (szz * sy - sz * szy) - sxz * (sxz * sy - sx * szy) +
+                sxy * (sxz * sz - szz * sx)) / det;
+
+    double len = std::sqrt(a * a + 1 + b * b);
+    plane.n[0] = (float)(-a / len);
+    plane.n[1] = (float)(1 / len);
+    plane.n[2] = (float)(-b / len);
+    plane.d = (float)(-c / len);
+    return true;
+}
+
+FloorEstimator::FloorEstimator()
+    : _stop(false), _busy(false), _stride(8), _interval(0),
+      _confidence(0), _valid(false)
+{
+}
+
+FloorEstimator::~FloorEstimator()
+{
+    stop();
+}
+
+void FloorEstimator::start(int stride, double interval)
+{
+    stop();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stride = std::max(stride, 1);
+    _interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(std::max(interval, 0.0)));
+    _lastSubmit = Clock::time_point();
+    _stop = false;
+    _worker = std::thread(&FloorEstimator::_workerLoop, this);
+}
+
+void FloorEstimator::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_one();
+
+    if (_worker.joinable())
+        _worker.join();
+}
+
+bool FloorEstimator::running() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _worker.joinable() && !_stop;
+}
+
+void FloorEstimator::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _valid = false;
+    _confidence = 0;
+    _plane = Plane();
+}
+
+void FloorEstimator::submit(const uint16_t *depth, int rows, int cols,
+                            const Intrinsics &intrinsics)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stop || !_worker.joinable() || _busy || !intrinsics.valid())
+        return;
+
+    Clock::time_point now = Clock::now();
+    if (now - _lastSubmit < _interval)
+        return;
+    _lastSubmit = now;
+
+    _pending.clear();
+    for (int r = 0; r < rows; r += _stride)
+    {
+        const uint16_t *row = depth + (size_t)r * cols;
+        for (int c = 0; c < cols; c += _stride)
+        {
+            if (!row[c] || row[c] > MAX_DEPTH)
+                continue;
+
+            float p[3];
+            intrinsics.backproject((float)c, (float)r, row[c], p);
+            _pending.insert(_pending.end(), p, p + 3);
+        }
+    }
+
+    _busy = true;
+    _cv.notify_one();
+}
+
+bool FloorEstimator::plane(Plane &plane, float &confidence) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    plane = _plane;
+    confidence = _confidence;
+    return _valid;
+}
+
+float FloorEstimator::_fit(const std::vector<float> &points, Plane &plane,
+                           bool hasPrevious)
+{
+    size_t count = points.size() / 3;
+    if (count < MIN_POINTS)
+        return 0;
+
+    std::uniform_int_distribution<size_t> pick(0, count - 1);
+    Plane best;
+    size_t bestInliers = 0;
+
+    for (int k = 0; k < RANSAC_ITERATIONS; k++)
+    {
+        const float *p0 = &points[pick(_rng) * 3];
+        const float *p1 = &points[pick(_rng) * 3];
+        const float *p2 = &points[pick(_rng) * 3];
+
+        float u[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float v[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        Plane h;
+        h.n[0] = u[1] * v[2] - u[2] * v[1];
+        h.n[1] = u[2] * v[0] - u[0] * v[2];
+        h.n[2] = u[0] * v[1] - u[1] * v[0];
+        float len = std::sqrt(h.n[0] * h.n[0] + h.n[1] * h.n[1] +
+                              h.n[2] * h.n[2]);
+        if (len < 1e-3f)
+            continue;
+
+        // The normal must point up, and the floor must be below the camera.
+        float sign = h.n[1] < 0 ? -1.0f : 1.0f;
+        for (int i = 0; i < 3; i++)
+            h.n[i] *= sign / len;
+        h.d = -(h.n[0] * p0[0] + h.n[1] * p0[1] + h.n[2] * p0[2]);
+        if (h.n[1] < MIN_UP_COSINE || h.d <= 0)
+            continue;
+
+        size_t inliers = countInliers(points, h);
+        if (inliers > bestInliers)
+        {
+            best = h;
+            bestInliers = inliers;
+        }
+    }
+
+    // Keep the previous estimate unless the new one is clearly better.
+    if (hasPrevious)
+    {
+        size_t previous = countInliers(points, plane);
+        if (previous * 20 >= bestInliers * 19)
+        {
+            best = plane;
+            bestInliers = previous;
+        }
+    }
+
+    if (!bestInliers || !refine(points, best))
+        return 0;
+
+    plane = best;
+    return (float)countInliers(points, plane) / count;
+}
+
+void FloorEstimator::_workerLoop()
+{
+    std::vector<float> points;
+    while (true)
+    {
+        Plane previous;
+        bool hasPrevious;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [&] { return _stop || _busy; });
+            if (_stop)
+            {
+                _busy = false;
+                return;
+            }
+            points.swap(_pending);
+            previous = _plane;
+            hasPrevious = _valid;
+        }
+
+        Plane plane = previous;
+        float confidence = _fit(points, plane, hasPrevious);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _busy = false;
+        if (confidence <= 0)
+            continue;
+
+        // Smooth small corrections, so the world frame does not jitter.
+        float cosine = plane.n[0] * previous.n[0] + plane.n[1] * previous.n[1] +
+                       plane.n[2] * previous.n[2];
+        if (hasPrevious && cosine > 0.996f &&
+            std::fabs(plane.d - previous.d) < 2 * INLIER_TOLERANCE)
+        {
+            float len = 0;
+            for (int i = 0; i < 3; i++)
+            {
+                plane.n[i] = previous.n[i] + SMOOTHING * (plane.n[i] - previous.n[i]);
+                len += plane.n[i] * plane.n[i];
+            }
+            len = std::sqrt(len);
+            for (int i = 0; i < 3; i++)
+                plane.n[i] /= len;
+            plane.d = previous.d + SMOOTHING * (plane.d - previous.d);
+        }
+
+        _plane = plane;
+        _confidence = confidence;
+        _valid = true;
+    }
+}
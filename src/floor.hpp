@@ -0,0 +1,170 @@
+/**
+ * @file floor.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the FloorEstimator class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef floor_H
+#define floor_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "geometry.hpp"
+
+/**
+ * @brief Estimates the floor plane from the depth stream.
+ *
+ * Depth frames are subsampled and back-projected on the caller's thread,
+ * which is cheap, while the RANSAC plane fit runs on a background thread.
+ * Each fit also scores the previous estimate, so the plane is refined
+ * incrementally over time instead of being recomputed from scratch.
+ */
+class FloorEstimator
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /// Background thread running the plane fit.
+    std::thread _worker;
+
+    /// Protects all members below.
+    mutable std::mutex _mutex;
+
+    /// Signals the worker that new points are available or it must stop.
+    std::condition_variable _cv;
+
+    /// Tells the worker to exit.
+    bool _stop;
+
+    /// Whether the worker is fitting a plane.
+    bool _busy;
+
+    /// Points waiting to be fitted, laid out as N x 3.
+    std::vector<float> _pending;
+
+    /// Pixel stride used to subsample the depth frames.
+    int _stride;
+
+    /// Minimum time between two fits.
+    Clock::duration _interval;
+
+    /// Time of the last submitted frame.
+    Clock::time_point _lastSubmit;
+
+    /// Current estimate.
+    Plane _plane;
+
+    /// Fraction of the sampled points lying on the current estimate.
+    float _confidence;
+
+    /// Whether there is an estimate.
+    bool _valid;
+
+    /// Random generator of the RANSAC.
+    std::mt19937 _rng;
+
+    /**
+     * @brief Main loop of the background thread.
+     */
+    void _workerLoop();
+
+    /**
+     * @brief Fits a plane to a set of points.
+     *
+     * @param points Points, laid out as N x 3.
+     * @param[in,out] plane Previous estimate on input, new one on output.
+     * @param hasPrevious Whether `plane` holds a previous estimate.
+     * @return float Fraction of points lying on the plane (0 on failure).
+     */
+    float _fit(const std::vector<float> &points, Plane &plane,
+               bool hasPrevious);
+
+public:
+    /**
+     * @brief Construct a new, stopped, FloorEstimator object.
+     */
+    FloorEstimator();
+
+    /**
+     * @brief Stops the background thread.
+     */
+    ~FloorEstimator();
+
+    /**
+     * @brief Starts estimating the floor.
+     *
+     * @param stride Pixel stride used to subsample the depth frames.
+     * @param interval Minimum time between two fits, in seconds.
+     */
+    void start(int stride, double interval);
+
+    /**
+     * @brief Stops the background thread. The last estimate is kept.
+     */
+    void stop();
+
+    /**
+     * @brief Returns whether the estimator is running.
+     */
+    bool running() const;
+
+    /**
+     * @brief Discards the current estimate.
+     */
+    void reset();
+
+    /**
+     * @brief Samples a depth frame, if a new fit is due and none is running.
+     *
+     * @param depth Depth frame, in millimeters.
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     * @param intrinsics Intrinsics of the depth camera.
+     */
+    void submit(const uint16_t *depth, int rows, int cols,
+                const Intrinsics &intrinsics);
+
+    /**
+     * @brief Returns the current estimate.
+     *
+     * @param[out] plane Floor plane, in the camera frame.
+     * @param[out] confidence Fraction of the sampled points on the plane.
+     * @return true if there is an estimate.
+     */
+    bool plane(Plane &plane, float &confidence) const;
+};
+
+#endif
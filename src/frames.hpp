@@ -0,0 +1,239 @@
+/**
+ * @file frames.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the SDK-independent frame types produced by the devices.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef frames_H
+#define frames_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Number of joints reported per skeleton (same order as "Skeleton").
+const int SKELETON_JOINTS = 20;
+
+/**
+ * @brief Depth or user label image. The data is owned by the device and is
+ *      only valid during the call that receives the image.
+ */
+struct DepthImage
+{
+    /// Timestamp, in microseconds.
+    uint64_t timestamp;
+
+    /// Number of rows.
+    int rows;
+
+    /// Number of columns.
+    int cols;
+
+    /// Depth in millimeters, or user labels (0 for background).
+    const uint16_t *data;
+};
+
+/**
+ * @brief Color image, in BGR order. The data is owned by the device and is
+ *      only valid during the call that receives the image.
+ */
+struct ColorImage
+{
+    /// Timestamp, in microseconds.
+    uint64_t timestamp;
+
+    /// Number of rows.
+    int rows;
+
+    /// Number of columns.
+    int cols;
+
+    /// Pixels, laid out as rows x cols x 3.
+    const uint8_t *data;
+};
+
+/**
+ * @brief Depth or user label image compressed with FrameCodec. The data is
+ *      only valid during the call that receives the image.
+ */
+struct CompressedImage
+{
+    /// Timestamp, in microseconds.
+    uint64_t timestamp;
+
+    /// Compressed frame.
+    const uint8_t *data;
+
+    /// Size of the compressed frame, in bytes.
+    size_t size;
+};
+
+/**
+ * @brief State of a skeleton joint.
+ */
+struct JointState
+{
+    /// Joint type, as in the Nuitrack JointType enumeration.
+    int type;
+
+    /// Tracking confidence (0 to 1).
+    float confidence;
+
+    /// Real coordinates, in millimeters.
+    float real[3];
+
+    /// Normalized projective coordinates (x, y in 0 to 1, z in mm).
+    float proj[3];
+
+    /// Row-major 3x3 orientation matrix.
+    float orient[9];
+};
+
+/**
+ * @brief Skeleton of a tracked user.
+ */
+struct SkeletonState
+{
+    /// ID of the user.
+    int userId;
+
+    /// Joints, in the order of the "Skeleton" tuple.
+    JointState joints[SKELETON_JOINTS];
+};
+
+/**
+ * @brief All skeletons tracked in a frame.
+ */
+struct SkeletonFrame
+{
+    /// Timestamp, in microseconds.
+    uint64_t timestamp;
+
+    /// Tracked skeletons.
+    std::vector<SkeletonState> skeletons;
+};
+
+/**
+ * @brief State of a hand.
+ */
+struct HandState
+{
+    /// Whether the hand is tracked. Other fields are undefined otherwise.
+    bool tracked;
+
+    /// Normalized projective coordinates (0 to 1).
+    float proj[2];
+
+    /// Whether the hand is performing a click.
+    bool click;
+
+    /// Click pressure.
+    int pressure;
+
+    /// Real coordinates, in millimeters.
+    float real[3];
+};
+
+/**
+ * @brief Hands of a tracked user.
+ */
+struct UserHandsState
+{
+    /// ID of the user.
+    int userId;
+
+    /// Left hand.
+    HandState left;
+
+    /// Right hand.
+    HandState right;
+};
+
+/**
+ * @brief All hands tracked in a frame.
+ */
+struct HandFrame
+{
+    /// Timestamp, in microseconds.
+    uint64_t timestamp;
+
+    /// Hands of each tracked user.
+    std::vector<UserHandsState> users;
+};
+
+/**
+ * @brief Built-in gesture detected by the sensor.
+ */
+struct GestureEvent
+{
+    /// ID of the user.
+    int userId;
+
+    /// Gesture type, as in the Nuitrack GestureType enumeration.
+    int type;
+};
+
+/**
+ * @brief Tracking issue of a user.
+ */
+struct IssueEvent
+{
+    /// ID of the user.
+    int userId;
+
+    /// Whether this is an occlusion issue (frame border issue otherwise).
+    bool occlusion;
+
+    /// Frame borders crossed by the user (frame border issues only).
+    bool left, right, top;
+};
+
+/**
+ * @brief Resolution and field of view of a stream.
+ */
+struct StreamMode
+{
+    StreamMode() : xres(0), yres(0), fps(0), hfov(0) {}
+
+    /// Image width.
+    int xres;
+
+    /// Image height.
+    int yres;
+
+    /// Frame rate.
+    int fps;
+
+    /// Horizontal field of view, in radians.
+    float hfov;
+};
+
+#endif
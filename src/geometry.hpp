@@ -0,0 +1,181 @@
+/**
+ * @file geometry.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the camera and plane helpers shared by the 3D stages.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef geometry_H
+#define geometry_H
+
+#include <cmath>
+
+/**
+ * @brief Pinhole intrinsics of the depth camera.
+ *
+ * Nuitrack real coordinates are in millimeters, with x pointing right, y
+ * pointing up and z pointing away from the sensor.
+ */
+struct Intrinsics
+{
+    Intrinsics() : fx(0), fy(0), cx(0), cy(0) {}
+
+    /**
+     * @brief Builds the intrinsics from the resolution and horizontal FOV.
+     *
+     * @param cols Image width.
+     * @param rows Image height.
+     * @param hfov Horizontal field of view, in radians.
+     */
+    Intrinsics(int cols, int rows, float hfov)
+    {
+        fx = fy = cols / (2.0f * std::tan(hfov / 2.0f));
+        cx = cols / 2.0f;
+        cy = rows / 2.0f;
+    }
+
+    /// Focal lengths, in pixels.
+    float fx, fy;
+
+    /// Principal point, in pixels.
+    float cx, cy;
+
+    /**
+     * @brief Returns whether the intrinsics were set.
+     */
+    bool valid() const
+    {
+        return fx > 0;
+    }
+
+    /**
+     * @brief Converts a depth pixel to real coordinates.
+     *
+     * @param col Column of the pixel.
+     * @param row Row of the pixel.
+     * @param depth Depth, in millimeters.
+     * @param[out] point Real coordinates.
+     */
+    void backproject(float col, float row, float depth, float *point) const
+    {
+        point[0] = (col - cx) * depth / fx;
+        point[1] = (cy - row) * depth / fy;
+        point[2] = depth;
+    }
+};
+
+/**
+ * @brief Rigid transform from the camera frame to another frame.
+ */
+struct RigidTransform
+{
+    /// Builds the identity transform.
+    RigidTransform()
+    {
+        for (int i = 0; i < 9; i++)
+            r[i] = i % 4 == 0 ? 1.0f : 0.0f;
+        t[0] = t[1] = t[2] = 0;
+    }
+
+    /// Row-major rotation.
+    float r[9];
+
+    /// Translation, applied after the rotation.
+    float t[3];
+
+    /**
+     * @brief Transforms a point. The input and output may be the same.
+     */
+    void apply(const float *in, float *out) const
+    {
+        float x = in[0], y = in[1], z = in[2];
+        out[0] = r[0] * x + r[1] * y + r[2] * z + t[0];
+        out[1] = r[3] * x + r[4] * y + r[5] * z + t[1];
+        out[2] = r[6] * x + r[7] * y + r[8] * z + t[2];
+    }
+};
+
+/**
+ * @brief Plane n.p + d = 0, with unit normal n.
+ */
+struct Plane
+{
+    Plane() : d(0)
+    {
+        n[0] = n[2] = 0;
+        n[1] = 1;
+    }
+
+    /// Unit normal.
+    float n[3];
+
+    /// Offset. For the floor, this is the height of the camera.
+    float d;
+
+    /**
+     * @brief Signed distance from a point to the plane.
+     */
+    float distance(const float *p) const
+    {
+        return n[0] * p[0] + n[1] * p[1] + n[2] * p[2] + d;
+    }
+
+    /**
+     * @brief Returns the gravity-aligned transform defined by the plane.
+     *
+     * The resulting frame has its origin on the plane, right below the
+     * camera, y along the plane normal and z along the camera's viewing
+     * direction projected on the plane.
+     */
+    RigidTransform worldTransform() const
+    {
+        // z axis: camera forward (0, 0, 1) projected on the plane.
+        float zx = -n[2] * n[0], zy = -n[2] * n[1], zz = 1 - n[2] * n[2];
+        float len = std::sqrt(zx * zx + zy * zy + zz * zz);
+        zx /= len;
+        zy /= len;
+        zz /= len;
+
+        RigidTransform world;
+        world.r[3] = n[0];
+        world.r[4] = n[1];
+        world.r[5] = n[2];
+        world.r[6] = zx;
+        world.r[7] = zy;
+        world.r[8] = zz;
+        // x axis = y cross z.
+        world.r[0] = n[1] * zz - n[2] * zy;
+        world.r[1] = n[2] * zx - n[0] * zz;
+        world.r[2] = n[0] * zy - n[1] * zx;
+        world.t[1] = d;
+        return world;
+    }
+};
+
+#endif
@@ -0,0 +1,312 @@
+/**
+ * @file gestures.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the template-based GestureMatcher class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "gestures.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define GESTURES_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GESTURES_NEON
+#endif
+
+/// Minimum number of user/template pairs worth spreading across threads.
+static const size_t PARALLEL_MIN_TASKS = 8;
+
+/// Indices of the torso and neck in the joint order of HISTORY_JOINTS.
+static const int TORSO = 2;
+static const int NECK = 1;
+
+/**
+ * @brief Euclidean distance between two normalized frames.
+ */
+static inline float frameDistance(const float *a, const float *b)
+{
+#if defined(GESTURES_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (int i = 0; i < GESTURE_DIMS; i += 4)
+    {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return std::sqrt(_mm_cvtss_f32(acc));
+#elif defined(GESTURES_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int i = 0; i < GESTURE_DIMS; i += 4)
+    {
+        float32x4_t d = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+        acc = vmlaq_f32(acc, d, d);
+    }
+    float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return std::sqrt(vget_lane_f32(vpadd_f32(sum, sum), 0));
+#else
+    float acc = 0;
+    for (int i = 0; i < GESTURE_DIMS; i++)
+    {
+        float d = a[i] - b[i];
+        acc += d * d;
+    }
+    return std::sqrt(acc);
+#endif
+}
+
+GestureMatcher::GestureMatcher(ThreadPool *pool)
+    : _nextId(0), _windowCapacity(0), _pool(pool)
+{
+}
+
+void GestureMatcher::normalize(const float *joints, float *features)
+{
+    const float *torso = joints + TORSO * 3;
+    const float *neck = joints + NECK * 3;
+
+    float dx = neck[0] - torso[0];
+    float dy = neck[1] - torso[1];
+    float dz = neck[2] - torso[2];
+    float scale = std::sqrt(dx * dx + dy * dy + dz * dz);
+    float inv = scale > 1e-6f ? 1.0f / scale : 1.0f;
+
+    for (int j = 0; j < HISTORY_JOINTS; j++)
+        for (int k = 0; k < 3; k++)
+            features[j * 3 + k] = (joints[j * 3 + k] - torso[k]) * inv;
+
+    std::fill(features + HISTORY_JOINTS * 3, features + GESTURE_DIMS, 0.0f);
+}
+
+void GestureMatcher::_resizeWindows()
+{
+    size_t longest = 0;
+    for (auto &tmpl : _templates)
+        longest = std::max(longest, tmpl.second.length);
+
+    _windowCapacity = 2 * longest;
+    for (auto &window : _windows)
+    {
+        Window &w = window.second;
+        if (w.length > _windowCapacity)
+        {
+            size_t drop = w.length - _windowCapacity;
+            std::memmove(&w.frames[0], &w.frames[drop * GESTURE_DIMS],
+                         _windowCapacity * GESTURE_DIMS * sizeof(float));
+            w.length = _windowCapacity;
+        }
+        w.frames.resize(_windowCapacity * GESTURE_DIMS);
+    }
+}
+
+int GestureMatcher::addTemplate(const float *joints, size_t length,
+                                float threshold)
+{
+    if (length < 2)
+        return -1;
+
+    Template tmpl;
+    tmpl.length = length;
+    tmpl.threshold = threshold;
+    tmpl.frames.resize(length * GESTURE_DIMS);
+    for (size_t i = 0; i < length; i++)
+        normalize(joints + i * HISTORY_JOINTS * 3, &tmpl.frames[i * GESTURE_DIMS]);
+
+    int id = _nextId++;
+    _templates[id] = tmpl;
+    _resizeWindows();
+    return id;
+}
+
+bool GestureMatcher::removeTemplate(int templateId)
+{
+    if (!_templates.erase(templateId))
+        return false;
+
+    _resizeWindows();
+    return true;
+}
+
+void GestureMatcher::clear()
+{
+    _templates.clear();
+    _windows.clear();
+    _dirty.clear();
+    _windowCapacity = 0;
+}
+
+bool GestureMatcher::enabled() const
+{
+    return !_templates.empty();
+}
+
+void GestureMatcher::push(int userId, const float *joints)
+{
+    if (!enabled())
+        return;
+
+    Window &w = _windows[userId];
+    if (w.frames.size() != _windowCapacity * GESTURE_DIMS)
+        w.frames.resize(_windowCapacity * GESTURE_DIMS);
+
+    if (w.length == _windowCapacity)
+    {
+        std::memmove(&w.frames[0], &w.frames[GESTURE_DIMS],
+                     (_windowCapacity - 1) * GESTURE_DIMS * sizeof(float));
+        w.length--;
+    }
+
+    normalize(joints, &w.frames[w.length * GESTURE_DIMS]);
+    w.length++;
+    _dirty.insert(userId);
+}
+
+float GestureMatcher::_dtw(const Template &tmpl, const Window &window)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    size_t n = tmpl.length;
+
+    // Only the end of the window is searched, which also bounds the warping
+    // to twice the template length.
+    size_t m = std::min(window.length, 2 * n);
+    if (m < n / 2 || !m)
+        return inf;
+
+    const float *frames = &window.frames[(window.length - m) * GESTURE_DIMS];
+    float limit = tmpl.threshold * n;
+
+    std::vector<float> prev(m), cur(m);
+    float rowMin = inf;
+    for (size_t j = 0; j < m; j++)
+    {
+        // Open begin: the gesture may start anywhere in the window.
+        prev[j] = frameDistance(&tmpl.frames[0], frames + j * GESTURE_DIMS);
+        rowMin = std::min(rowMin, prev[j]);
+    }
+    if (rowMin > limit)
+        return inf;
+
+    for (size_t i = 1; i < n; i++)
+    {
+        const float *t = &tmpl.frames[i * GESTURE_DIMS];
+        cur[0] = prev[0] + frameDistance(t, frames);
+        rowMin = cur[0];
+        for (size_t j = 1; j < m; j++)
+        {
+            float best = std::min(prev[j], std::min(prev[j - 1], cur[j - 1]));
+            cur[j] = best + frameDistance(t, frames + j * GESTURE_DIMS);
+            rowMin = std::min(rowMin, cur[j]);
+        }
+
+        // Every warping path crosses every row, and costs only grow.
+        if (rowMin > limit)
+            return inf;
+        prev.swap(cur);
+    }
+
+    return prev[m - 1] / n;
+}
+
+void GestureMatcher::match(std::vector<Match> &matches)
+{
+    matches.clear();
+    if (!enabled() || _dirty.empty())
+        return;
+
+    struct Task
+    {
+        int userId;
+        int templateId;
+        const Template *tmpl;
+        const Window *window;
+    };
+
+    std::vector<Task> tasks;
+    for (int userId : _dirty)
+    {
+        auto window = _windows.find(userId);
+        if (window == _windows.end())
+            continue;
+        for (auto &tmpl : _templates)
+        {
+            Task task = {userId, tmpl.first, &tmpl.second, &window->second};
+            tasks.push_back(task);
+        }
+    }
+    _dirty.clear();
+
+    std::vector<float> scores(tasks.size());
+    std::function<void(size_t, size_t)> body = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+            scores[i] = _dtw(*tasks[i].tmpl, *tasks[i].window);
+    };
+
+    if (_pool && tasks.size() >= PARALLEL_MIN_TASKS)
+        _pool->parallelFor(tasks.size(), body);
+    else
+        body(0, tasks.size());
+
+    // Tasks are grouped by user, so the best match per user is kept by
+    // comparing against the last reported match.
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        if (scores[i] > tasks[i].tmpl->threshold)
+            continue;
+
+        if (!matches.empty() && matches.back().userId == tasks[i].userId)
+        {
+            if (scores[i] < matches.back().score)
+            {
+                matches.back().templateId = tasks[i].templateId;
+                matches.back().score = scores[i];
+            }
+        }
+        else
+        {
+            Match m = {tasks[i].userId, tasks[i].templateId, scores[i]};
+            matches.push_back(m);
+        }
+    }
+
+    for (const Match &m : matches)
+        _windows[m.userId].length = 0;
+}
+
+void GestureMatcher::evict(int userId)
+{
+    _windows.erase(userId);
+    _dirty.erase(userId);
+}
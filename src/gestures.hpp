@@ -0,0 +1,210 @@
+/**
+ * @file gestures.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the template-based GestureMatcher class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef gestures_H
+#define gestures_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "history.hpp"
+#include "threadpool.hpp"
+
+/// Floats per normalized frame (HISTORY_JOINTS x 3, padded for SIMD).
+const int GESTURE_DIMS = 64;
+
+/**
+ * @brief Matches joint trajectories against registered gesture templates.
+ *
+ * Every skeleton is normalized (centered on the torso and scaled by the
+ * torso-neck distance) and appended to a sliding window per user. On each
+ * frame, every template is compared against the end of the window of every
+ * updated user with subsequence dynamic time warping (DTW), so a gesture is
+ * detected as soon as its last frame is seen. The DTW is abandoned as soon as
+ * a row can no longer end under the template threshold.
+ */
+class GestureMatcher
+{
+public:
+    /**
+     * @brief A detected gesture.
+     */
+    struct Match
+    {
+        /// ID of the user that performed the gesture.
+        int userId;
+
+        /// ID of the matched template.
+        int templateId;
+
+        /// Total distance along the warping path divided by the template
+        /// length, so thresholds do not depend on how the path warps.
+        float score;
+    };
+
+private:
+    /**
+     * @brief A registered gesture template.
+     */
+    struct Template
+    {
+        /// Number of frames.
+        size_t length;
+
+        /// Maximum score accepted as a match.
+        float threshold;
+
+        /// Normalized frames, laid out as length x GESTURE_DIMS.
+        std::vector<float> frames;
+    };
+
+    /**
+     * @brief Sliding window with the latest normalized frames of a user.
+     */
+    struct Window
+    {
+        Window() : length(0) {}
+
+        /// Number of valid frames.
+        size_t length;
+
+        /// Normalized frames, laid out as capacity x GESTURE_DIMS.
+        std::vector<float> frames;
+    };
+
+    /// Registered templates, indexed by template ID.
+    std::map<int, Template> _templates;
+
+    /// ID given to the next registered template.
+    int _nextId;
+
+    /// Number of frames kept per user (twice the longest template).
+    size_t _windowCapacity;
+
+    /// Window of each tracked user, indexed by the user ID.
+    std::map<int, Window> _windows;
+
+    /// Users updated since the last call to match().
+    std::set<int> _dirty;
+
+    /// Pool used when there are many user/template pairs (may be NULL).
+    ThreadPool *_pool;
+
+    /**
+     * @brief Resizes all windows after the set of templates has changed.
+     */
+    void _resizeWindows();
+
+    /**
+     * @brief Computes the subsequence DTW score of a template.
+     *
+     * @param tmpl Template to be matched.
+     * @param window Window of a user.
+     * @return float Cost of the best warping path divided by the template
+     *      length, or infinity if the DTW was abandoned.
+     */
+    static float _dtw(const Template &tmpl, const Window &window);
+
+public:
+    /**
+     * @brief Construct a new GestureMatcher object without templates.
+     *
+     * @param pool Pool used to spread the matching across cores, or NULL.
+     */
+    GestureMatcher(ThreadPool *pool = NULL);
+
+    /**
+     * @brief Normalizes a skeleton into a GESTURE_DIMS feature vector.
+     *
+     * @param joints HISTORY_JOINTS x 3 joint positions.
+     * @param[out] features GESTURE_DIMS normalized values.
+     */
+    static void normalize(const float *joints, float *features);
+
+    /**
+     * @brief Registers a new template.
+     *
+     * @param joints length x HISTORY_JOINTS x 3 joint positions.
+     * @param length Number of frames of the template (at least 2).
+     * @param threshold Maximum score accepted as a match.
+     * @return int ID of the template, or -1 if it is too short.
+     */
+    int addTemplate(const float *joints, size_t length, float threshold);
+
+    /**
+     * @brief Removes a template.
+     *
+     * @param templateId ID of the template.
+     * @return true if the template existed.
+     */
+    bool removeTemplate(int templateId);
+
+    /**
+     * @brief Removes all templates and user windows.
+     */
+    void clear();
+
+    /**
+     * @brief Returns whether any template is registered.
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Appends a skeleton to the window of a user.
+     *
+     * @param userId ID of the user.
+     * @param joints HISTORY_JOINTS x 3 joint positions.
+     */
+    void push(int userId, const float *joints);
+
+    /**
+     * @brief Matches all templates against the users updated since the last
+     *      call. The window of a user is cleared after a match, so the same
+     *      performance is not reported twice.
+     *
+     * @param[out] matches Detected gestures, at most one (the best) per user.
+     */
+    void match(std::vector<Match> &matches);
+
+    /**
+     * @brief Drops the window of a user that is no longer tracked.
+     *
+     * @param userId ID of the lost user.
+     */
+    void evict(int userId);
+};
+
+#endif
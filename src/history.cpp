@@ -0,0 +1,226 @@
+/**
+ * @file history.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the per-user trajectory history store.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "history.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+/**
+ * @brief Copies `length` ring elements of size `stride`, starting at `start`.
+ *
+ * The copy is split in at most two contiguous blocks, one before and one
+ * after the wrap-around point.
+ */
+template <typename T>
+void copyRing(const std::vector<T> &ring, size_t capacity, size_t stride,
+              size_t start, size_t length, std::vector<T> &out)
+{
+    out.resize(length * stride);
+    if (!length)
+        return;
+
+    size_t first = std::min(length, capacity - start);
+    std::memcpy(&out[0], &ring[start * stride], first * stride * sizeof(T));
+    if (length > first)
+        std::memcpy(&out[first * stride], &ring[0],
+                    (length - first) * stride * sizeof(T));
+}
+}
+
+UserHistory::UserHistory(size_t capacity)
+    : _capacity(capacity),
+      _skelHead(0),
+      _skelCount(0),
+      _handHead(0),
+      _handCount(0),
+      _skelTimestamp(capacity),
+      _joints(capacity * HISTORY_JOINTS * 3),
+      _confidence(capacity * HISTORY_JOINTS),
+      _handTimestamp(capacity),
+      _hands(capacity * HISTORY_HANDS * 3),
+      _click(capacity * HISTORY_HANDS),
+      _pressure(capacity * HISTORY_HANDS)
+{
+}
+
+void UserHistory::pushSkeleton(uint64_t timestamp, const float *joints,
+                               const float *confidence)
+{
+    _skelTimestamp[_skelHead] = timestamp;
+    std::memcpy(&_joints[_skelHead * HISTORY_JOINTS * 3], joints,
+                HISTORY_JOINTS * 3 * sizeof(float));
+    std::memcpy(&_confidence[_skelHead * HISTORY_JOINTS], confidence,
+                HISTORY_JOINTS * sizeof(float));
+
+    _skelHead = (_skelHead + 1) % _capacity;
+    _skelCount = std::min(_skelCount + 1, _capacity);
+}
+
+void UserHistory::pushHands(uint64_t timestamp, const float *hands,
+                            const uint8_t *click, const int32_t *pressure)
+{
+    _handTimestamp[_handHead] = timestamp;
+    std::memcpy(&_hands[_handHead * HISTORY_HANDS * 3], hands,
+                HISTORY_HANDS * 3 * sizeof(float));
+    std::memcpy(&_click[_handHead * HISTORY_HANDS], click,
+                HISTORY_HANDS * sizeof(uint8_t));
+    std::memcpy(&_pressure[_handHead * HISTORY_HANDS], pressure,
+                HISTORY_HANDS * sizeof(int32_t));
+
+    _handHead = (_handHead + 1) % _capacity;
+    _handCount = std::min(_handCount + 1, _capacity);
+}
+
+size_t UserHistory::_window(const std::vector<uint64_t> &timestamps,
+                            size_t head, size_t count, double seconds,
+                            size_t &length) const
+{
+    length = count;
+    size_t oldest = (head + _capacity - count) % _capacity;
+    if (!count || seconds < 0)
+        return oldest;
+
+    // Walk back from the newest sample until it falls out of the window.
+    uint64_t newest = timestamps[(head + _capacity - 1) % _capacity];
+    uint64_t span = (uint64_t)(seconds * 1e6);
+    uint64_t limit = newest > span ? newest - span : 0;
+
+    length = 0;
+    while (length < count &&
+           timestamps[(head + _capacity - 1 - length) % _capacity] >= limit)
+        length++;
+
+    return (head + _capacity - length) % _capacity;
+}
+
+size_t UserHistory::skeletonWindow(double seconds,
+                                   std::vector<uint64_t> &timestamp,
+                                   std::vector<float> &joints,
+                                   std::vector<float> &confidence) const
+{
+    size_t length;
+    size_t start = _window(_skelTimestamp, _skelHead, _skelCount, seconds,
+                           length);
+
+    copyRing(_skelTimestamp, _capacity, 1, start, length, timestamp);
+    copyRing(_joints, _capacity, HISTORY_JOINTS * 3, start, length, joints);
+    copyRing(_confidence, _capacity, HISTORY_JOINTS, start, length,
+             confidence);
+    return length;
+}
+
+size_t UserHistory::handWindow(double seconds,
+                               std::vector<uint64_t> &timestamp,
+                               std::vector<float> &hands,
+                               std::vector<uint8_t> &click,
+                               std::vector<int32_t> &pressure) const
+{
+    size_t length;
+    size_t start = _window(_handTimestamp, _handHead, _handCount, seconds,
+                           length);
+
+    copyRing(_handTimestamp, _capacity, 1, start, length, timestamp);
+    copyRing(_hands, _capacity, HISTORY_HANDS * 3, start, length, hands);
+    copyRing(_click, _capacity, HISTORY_HANDS, start, length, click);
+    copyRing(_pressure, _capacity, HISTORY_HANDS, start, length, pressure);
+    return length;
+}
+
+HistoryStore::HistoryStore() : _capacity(0)
+{
+}
+
+void HistoryStore::setCapacity(size_t capacity)
+{
+    _capacity = capacity;
+    _users.clear();
+}
+
+size_t HistoryStore::capacity() const
+{
+    return _capacity;
+}
+
+bool HistoryStore::enabled() const
+{
+    return _capacity > 0;
+}
+
+UserHistory &HistoryStore::_get(int userId)
+{
+    auto it = _users.find(userId);
+    if (it == _users.end())
+        it = _users.insert(std::make_pair(userId, UserHistory(_capacity))).first;
+    return it->second;
+}
+
+void HistoryStore::pushSkeleton(int userId, uint64_t timestamp,
+                                const float *joints, const float *confidence)
+{
+    if (enabled())
+        _get(userId).pushSkeleton(timestamp, joints, confidence);
+}
+
+void HistoryStore::pushHands(int userId, uint64_t timestamp,
+                             const float *hands, const uint8_t *click,
+                             const int32_t *pressure)
+{
+    if (enabled())
+        _get(userId).pushHands(timestamp, hands, click, pressure);
+}
+
+void HistoryStore::evict(int userId)
+{
+    _users.erase(userId);
+}
+
+void HistoryStore::clear()
+{
+    _users.clear();
+}
+
+const UserHistory *HistoryStore::find(int userId) const
+{
+    auto it = _users.find(userId);
+    return it == _users.end() ? NULL : &it->second;
+}
+
+std::vector<int> HistoryStore::users() const
+{
+    std::vector<int> ids;
+    for (auto &user : _users)
+        ids.push_back(user.first);
+    return ids;
+}
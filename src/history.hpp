@@ -0,0 +1,249 @@
+/**
+ * @file history.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the per-user trajectory history store.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef history_H
+#define history_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "frames.hpp"
+
+/// Number of joints stored per skeleton sample (same order as "Skeleton").
+const int HISTORY_JOINTS = SKELETON_JOINTS;
+
+/// Number of hands stored per hand sample (left and right).
+const int HISTORY_HANDS = 2;
+
+/**
+ * @brief Fixed-capacity ring buffer with the trajectory of a single user.
+ *
+ * Skeleton and hand samples arrive from different Nuitrack modules, so each
+ * has its own ring and timestamps. Data is kept as structure-of-arrays, so a
+ * window can be copied out with at most two contiguous copies per field.
+ */
+class UserHistory
+{
+private:
+    /// Maximum number of samples kept in each ring.
+    size_t _capacity;
+
+    /// Index of the next skeleton sample to be written.
+    size_t _skelHead;
+
+    /// Number of valid skeleton samples.
+    size_t _skelCount;
+
+    /// Index of the next hand sample to be written.
+    size_t _handHead;
+
+    /// Number of valid hand samples.
+    size_t _handCount;
+
+    /// Skeleton timestamps, in microseconds.
+    std::vector<uint64_t> _skelTimestamp;
+
+    /// Joint positions, laid out as capacity x HISTORY_JOINTS x 3.
+    std::vector<float> _joints;
+
+    /// Joint confidences, laid out as capacity x HISTORY_JOINTS.
+    std::vector<float> _confidence;
+
+    /// Hand timestamps, in microseconds.
+    std::vector<uint64_t> _handTimestamp;
+
+    /// Hand positions, laid out as capacity x HISTORY_HANDS x 3.
+    std::vector<float> _hands;
+
+    /// Hand click state, laid out as capacity x HISTORY_HANDS.
+    std::vector<uint8_t> _click;
+
+    /// Hand pressure, laid out as capacity x HISTORY_HANDS.
+    std::vector<int32_t> _pressure;
+
+    /**
+     * @brief Finds the ring range covering the last `seconds` of samples.
+     *
+     * @param timestamps Ring of timestamps.
+     * @param head Index of the next sample to be written.
+     * @param count Number of valid samples.
+     * @param seconds Window length. Negative values select the whole ring.
+     * @param[out] length Number of samples inside the window.
+     * @return size_t Index of the first (oldest) sample inside the window.
+     */
+    size_t _window(const std::vector<uint64_t> &timestamps, size_t head,
+                   size_t count, double seconds, size_t &length) const;
+
+public:
+    /**
+     * @brief Construct a new, empty, UserHistory object.
+     *
+     * @param capacity Maximum number of samples kept for skeletons and hands.
+     */
+    UserHistory(size_t capacity);
+
+    /**
+     * @brief Appends a skeleton sample, overwriting the oldest when full.
+     *
+     * @param timestamp Sample timestamp, in microseconds.
+     * @param joints HISTORY_JOINTS x 3 joint positions.
+     * @param confidence HISTORY_JOINTS joint confidences.
+     */
+    void pushSkeleton(uint64_t timestamp, const float *joints,
+                      const float *confidence);
+
+    /**
+     * @brief Appends a hand sample, overwriting the oldest when full.
+     *
+     * @param timestamp Sample timestamp, in microseconds.
+     * @param hands HISTORY_HANDS x 3 hand positions (NaN when not tracked).
+     * @param click HISTORY_HANDS click states.
+     * @param pressure HISTORY_HANDS pressure values.
+     */
+    void pushHands(uint64_t timestamp, const float *hands,
+                   const uint8_t *click, const int32_t *pressure);
+
+    /**
+     * @brief Copies the last `seconds` of skeleton samples, oldest first.
+     *
+     * @param seconds Window length. Negative values return the whole ring.
+     * @param[out] timestamp T timestamps.
+     * @param[out] joints T x HISTORY_JOINTS x 3 joint positions.
+     * @param[out] confidence T x HISTORY_JOINTS joint confidences.
+     * @return size_t Number of samples T.
+     */
+    size_t skeletonWindow(double seconds, std::vector<uint64_t> &timestamp,
+                          std::vector<float> &joints,
+                          std::vector<float> &confidence) const;
+
+    /**
+     * @brief Copies the last `seconds` of hand samples, oldest first.
+     *
+     * @param seconds Window length. Negative values return the whole ring.
+     * @param[out] timestamp T timestamps.
+     * @param[out] hands T x HISTORY_HANDS x 3 hand positions.
+     * @param[out] click T x HISTORY_HANDS click states.
+     * @param[out] pressure T x HISTORY_HANDS pressure values.
+     * @return size_t Number of samples T.
+     */
+    size_t handWindow(double seconds, std::vector<uint64_t> &timestamp,
+                      std::vector<float> &hands, std::vector<uint8_t> &click,
+                      std::vector<int32_t> &pressure) const;
+};
+
+/**
+ * @brief Keeps one UserHistory per tracked user.
+ *
+ * A capacity of zero disables the store, so the update path costs nothing
+ * when no history is requested.
+ */
+class HistoryStore
+{
+private:
+    /// Capacity used for newly created users.
+    size_t _capacity;
+
+    /// History of each user, indexed by the user ID.
+    std::map<int, UserHistory> _users;
+
+    /**
+     * @brief Returns the history of the given user, creating it if needed.
+     *
+     * @param userId ID of the user.
+     * @return UserHistory& History of the user.
+     */
+    UserHistory &_get(int userId);
+
+public:
+    /**
+     * @brief Construct a new, disabled, HistoryStore object.
+     */
+    HistoryStore();
+
+    /**
+     * @brief Sets the number of samples kept per user and clears the store.
+     *
+     * @param capacity Number of samples. Zero disables the store.
+     */
+    void setCapacity(size_t capacity);
+
+    /**
+     * @brief Returns the number of samples kept per user.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Returns whether the store is recording.
+     */
+    bool enabled() const;
+
+    /**
+     * @brief See UserHistory::pushSkeleton.
+     */
+    void pushSkeleton(int userId, uint64_t timestamp, const float *joints,
+                      const float *confidence);
+
+    /**
+     * @brief See UserHistory::pushHands.
+     */
+    void pushHands(int userId, uint64_t timestamp, const float *hands,
+                   const uint8_t *click, const int32_t *pressure);
+
+    /**
+     * @brief Drops the history of a user that is no longer tracked.
+     *
+     * @param userId ID of the lost user.
+     */
+    void evict(int userId);
+
+    /**
+     * @brief Drops the history of all users.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the history of a user, or NULL if it is not stored.
+     *
+     * @param userId ID of the user.
+     */
+    const UserHistory *find(int userId) const;
+
+    /**
+     * @brief Returns the IDs of all users with stored history.
+     */
+    std::vector<int> users() const;
+};
+
+#endif
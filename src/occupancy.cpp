@@ -0,0 +1,147 @@
+/**
+ * @file occupancy.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the OccupancyMap class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "occupancy.hpp"
+#include <algorithm>
+#include <cmath>
+
+/// Largest gap (s) between two samples still counted as dwell time.
+static const double MAX_SAMPLE_GAP = 1.0;
+
+/// Smallest displacement (mm) that extends a path, to ignore jitter.
+static const float PATH_JITTER = 50.0f;
+
+OccupancyMap::OccupancyMap()
+{
+}
+
+void OccupancyMap::configure(const OccupancyGrid &grid)
+{
+    _grid = grid;
+    if (_grid.cols < 0 || _grid.rows < 0 || _grid.cellSize <= 0)
+        _grid.cols = _grid.rows = 0;
+    reset();
+}
+
+const OccupancyGrid &OccupancyMap::grid() const
+{
+    return _grid;
+}
+
+bool OccupancyMap::enabled() const
+{
+    return _grid.cols > 0 && _grid.rows > 0;
+}
+
+void OccupancyMap::add(int userId, uint64_t timestamp, float x, float z)
+{
+    if (!enabled())
+        return;
+
+    auto it = _tracks.find(userId);
+    if (it == _tracks.end())
+    {
+        Track track = {0, 0, {x, z}, timestamp, true};
+        it = _tracks.insert(std::make_pair(userId, track)).first;
+    }
+    Track &track = it->second;
+
+    double dt = timestamp > track.timestamp ?
+                (timestamp - track.timestamp) * 1e-6 : 0;
+    if (dt > MAX_SAMPLE_GAP)
+        dt = 0;
+    track.timestamp = timestamp;
+    track.duration += dt;
+
+    if (!track.anchored)
+    {
+        track.anchor[0] = x;
+        track.anchor[1] = z;
+        track.anchored = true;
+    }
+
+    float dx = x - track.anchor[0];
+    float dz = z - track.anchor[1];
+    float step = std::sqrt(dx * dx + dz * dz);
+    if (step >= PATH_JITTER)
+    {
+        track.pathLength += step;
+        track.anchor[0] = x;
+        track.anchor[1] = z;
+    }
+
+    int col = (int)std::floor((x - _grid.xMin) / _grid.cellSize);
+    int row = (int)std::floor((z - _grid.zMin) / _grid.cellSize);
+    if (col < 0 || col >= _grid.cols || row < 0 || row >= _grid.rows)
+        return;
+
+    size_t cell = (size_t)row * _grid.cols + col;
+    _counts[cell]++;
+    _dwell[cell] += dt;
+}
+
+void OccupancyMap::evict(int userId)
+{
+    _tracks.erase(userId);
+}
+
+void OccupancyMap::reset()
+{
+    size_t cells = (size_t)_grid.cols * _grid.rows;
+    _counts.assign(cells, 0);
+    _dwell.assign(cells, 0.0);
+    _tracks.clear();
+}
+
+void OccupancyMap::changeFrame()
+{
+    std::fill(_counts.begin(), _counts.end(), 0);
+    std::fill(_dwell.begin(), _dwell.end(), 0.0);
+    for (auto &track : _tracks)
+        track.second.anchored = false;
+}
+
+const std::vector<uint32_t> &OccupancyMap::counts() const
+{
+    return _counts;
+}
+
+const std::vector<double> &OccupancyMap::dwell() const
+{
+    return _dwell;
+}
+
+const std::map<int, OccupancyMap::Track> &OccupancyMap::tracks() const
+{
+    return _tracks;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file occupancy.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the OccupancyMap class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef occupancy_H
+#define occupancy_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * @brief Floor grid used by the OccupancyMap. Empty grids are disabled.
+ */
+struct OccupancyGrid
+{
+    OccupancyGrid() : xMin(0), zMin(0), cellSize(100), cols(0), rows(0) {}
+
+    /// Floor coordinates (mm) of the corner of the first cell.
+    float xMin, zMin;
+
+    /// Side of each cell, in millimeters.
+    float cellSize;
+
+    /// Number of cells along x.
+    int cols;
+
+    /// Number of cells along z.
+    int rows;
+};
+
+/**
+ * @brief Accumulates where tracked users stand and for how long.
+ *
+ * Each sample costs a few operations: the user position is binned into the
+ * grid, the cell counters are incremented and the user's path is extended.
+ * Snapshots are only built when requested.
+ */
+class OccupancyMap
+{
+public:
+    /**
+     * @brief Running statistics of a tracked user.
+     */
+    struct Track
+    {
+        /// Distance walked, in millimeters.
+        double pathLength;
+
+        /// Time since the user was first seen, in seconds.
+        double duration;
+
+        /// Last position that extended the path.
+        float anchor[2];
+
+        /// Timestamp of the last sample, in microseconds.
+        uint64_t timestamp;
+
+        /// Whether the anchor is in the frame of the next sample.
+        bool anchored;
+    };
+
+private:
+    /// Current grid.
+    OccupancyGrid _grid;
+
+    /// Number of samples that fell in each cell, laid out as rows x cols.
+    std::vector<uint32_t> _counts;
+
+    /// Time (s) spent by users in each cell, laid out as rows x cols. Kept
+    /// in double so short samples still add up after hours of tracking.
+    std::vector<double> _dwell;
+
+    /// Statistics of each tracked user, indexed by the user ID.
+    std::map<int, Track> _tracks;
+
+public:
+    /**
+     * @brief Construct a new, disabled, OccupancyMap object.
+     */
+    OccupancyMap();
+
+    /**
+     * @brief Sets the grid and clears all accumulators.
+     *
+     * @param grid New grid. A grid without cells disables the map.
+     */
+    void configure(const OccupancyGrid &grid);
+
+    /**
+     * @brief Returns the current grid.
+     */
+    const OccupancyGrid &grid() const;
+
+    /**
+     * @brief Returns whether the map is accumulating.
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Adds the position of a user.
+     *
+     * @param userId ID of the user.
+     * @param timestamp Timestamp of the sample, in microseconds.
+     * @param x Position along the floor x axis, in millimeters.
+     * @param z Position along the floor z axis, in millimeters.
+     */
+    void add(int userId, uint64_t timestamp, float x, float z);
+
+    /**
+     * @brief Drops the statistics of a user that is no longer tracked.
+     *
+     * @param userId ID of the lost user.
+     */
+    void evict(int userId);
+
+    /**
+     * @brief Clears all accumulators.
+     */
+    void reset();
+
+    /**
+     * @brief Clears the cells and re-anchors the paths at their next sample,
+     *      as positions are now given in another frame. Path lengths and
+     *      durations are kept.
+     */
+    void changeFrame();
+
+    /**
+     * @brief Returns the number of samples per cell (rows x cols).
+     */
+    const std::vector<uint32_t> &counts() const;
+
+    /**
+     * @brief Returns the dwell time per cell, in seconds (rows x cols).
+     */
+    const std::vector<double> &dwell() const;
+
+    /**
+     * @brief Returns the statistics of the tracked users.
+     */
+    const std::map<int, Track> &tracks() const;
+};
+
+#endif
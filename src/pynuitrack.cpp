@@ -32,23 +32,110 @@
 
 #include "pynuitrack.hpp"
 #include <boost/algorithm/string.hpp>
+#include <nuitrack/Nuitrack.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace nt = tdv::nuitrack;
 namespace bp = boost::python;
 namespace np = boost::python::numpy;
 
-NuitrackException::NuitrackException(std::string message)
+/**
+ * @brief Holds the GIL for the lifetime of the object.
+ * 
+ * Devices call back without the GIL, so it must be taken before touching any
+ * Python object.
+ */
+class ScopedGIL
+{
+private:
+    /// State to be restored.
+    PyGILState_STATE _state;
+
+public:
+    ScopedGIL() : _state(PyGILState_Ensure()) {}
+    ~ScopedGIL() { PyGILState_Release(_state); }
+};
+
+/**
+ * @brief Releases the GIL for the lifetime of the object.
+ */
+class ScopedNoGIL
+{
+private:
+    /// Thread state to be restored.
+    PyThreadState *_state;
+
+public:
+    ScopedNoGIL() : _state(PyEval_SaveThread()) {}
+    ~ScopedNoGIL() { PyEval_RestoreThread(_state); }
+};
+
+/**
+ * @brief Copies a contiguous buffer into a new numpy array.
+ * 
+ * @param data Buffer with at least as many elements as the given shape.
+ * @param shape Shape of the array.
+ * @return np::ndarray A numpy array that owns its data.
+ */
+template <typename T>
+static np::ndarray toArray(const std::vector<T> &data, bp::tuple shape)
+{
+    np::ndarray array = np::empty(shape, np::dtype::get_builtin<T>());
+    if (!data.empty())
+        std::memcpy(array.get_data(), &data[0], data.size() * sizeof(T));
+    return array;
+}
+
+/**
+ * @brief Copies a contiguous buffer into a new numpy array.
+ * 
+ * @param data Buffer with as many elements as the given shape.
+ * @param shape Shape of the array.
+ * @return np::ndarray A numpy array that owns its data.
+ */
+template <typename T>
+static np::ndarray toArray(const T *data, bp::tuple shape)
 {
-    this->message = message;
+    np::ndarray array = np::empty(shape, np::dtype::get_builtin<T>());
+    size_t count = 1;
+    for (int i = 0; i < array.get_nd(); i++)
+        count *= array.shape(i);
+    std::memcpy(array.get_data(), data, count * sizeof(T));
+    return array;
 }
 
-const char *NuitrackException::what() const throw()
+/**
+ * @brief Copies a compressed frame into a new Python bytes object.
+ */
+static bp::object toBytes(const uint8_t *data, size_t size)
 {
-    return this->message.c_str();
+    return bp::object(bp::handle<>(PyBytes_FromStringAndSize(
+        (const char *)data, size)));
 }
 
-NuitrackException::~NuitrackException() throw()
+/// Python callback shared by the native callbacks wrapping it.
+typedef std::shared_ptr<bp::object> PyCallback;
+
+/**
+ * @brief Takes a reference to a Python callback, so it stays alive while
+ *      the Tracker may call it. The reference is dropped with the GIL, from
+ *      whichever thread releases the last copy.
+ * 
+ * @param callable Python function, or None.
+ * @return PyCallback The callback, or empty if None.
+ */
+static PyCallback toCallback(bp::object callable)
 {
+    if (callable.is_none())
+        return PyCallback();
+
+    return PyCallback(new bp::object(callable), [](bp::object *object)
+    {
+        ScopedGIL gil;
+        delete object;
+    });
 }
 
 void translateException(NuitrackException const &e)
@@ -58,14 +145,18 @@ void translateException(NuitrackException const &e)
 
 Nuitrack::Nuitrack()
 {
-    _pyDepthCallback = NULL;
-    _pyColorCallback = NULL;
-    _pySkeletonCallback = NULL;
-    _pyHandsCallback = NULL;
-    _pyUserCallback = NULL;
-    _pyGestureCallback = NULL;
-    _pyIssueCallback = NULL;
-    _pyFaceCallback = NULL;
+    // The worker thread keeps its Python thread state while it runs.
+    _tracker.setWorkerHooks(
+        [this]()
+        {
+            _workerGIL = PyGILState_Ensure();
+            _workerState = PyEval_SaveThread();
+        },
+        [this]()
+        {
+            PyEval_RestoreThread(_workerState);
+            PyGILState_Release(_workerGIL);
+        });
 
     _yaml = bp::import("yaml");
 
@@ -126,7 +217,12 @@ Nuitrack::Nuitrack()
     bp::list fieldsGesture;
     fieldsGesture.append("userId");
     fieldsGesture.append("type");
+    fieldsGesture.append("template");
+    fieldsGesture.append("score");
     _Gesture = _namedtuple("Gesture", fieldsGesture);
+    // Built-in gestures have no template nor score.
+    _Gesture.attr("__new__").attr("__defaults__") =
+        bp::make_tuple(bp::object(), bp::object());
 
     bp::list fieldsFBIssue;
     fieldsFBIssue.append("userId");
@@ -138,361 +234,823 @@ Nuitrack::Nuitrack()
     bp::list fieldsOIssue;
     fieldsOIssue.append("userId");
     _OcclusionIssue = _namedtuple("OcclusionIssue", fieldsOIssue);
+
+    bp::list fieldsHistory;
+    fieldsHistory.append("timestamp");
+    fieldsHistory.append("joints");
+    fieldsHistory.append("confidence");
+    _History = _namedtuple("History", fieldsHistory);
+
+    bp::list fieldsHandHistory;
+    fieldsHandHistory.append("timestamp");
+    fieldsHandHistory.append("real");
+    fieldsHandHistory.append("click");
+    fieldsHandHistory.append("pressure");
+    _HandHistory = _namedtuple("HandHistory", fieldsHandHistory);
+
+    bp::list fieldsFloor;
+    fieldsFloor.append("normal");
+    fieldsFloor.append("d");
+    fieldsFloor.append("confidence");
+    fieldsFloor.append("transform");
+    _Floor = _namedtuple("Floor", fieldsFloor);
+
+    bp::list fieldsOccupancy;
+    fieldsOccupancy.append("counts");
+    fieldsOccupancy.append("dwell");
+    fieldsOccupancy.append("users");
+    _Occupancy = _namedtuple("Occupancy", fieldsOccupancy);
+
+    bp::list fieldsUserPath;
+    fieldsUserPath.append("path_length");
+    fieldsUserPath.append("duration");
+    _UserPath = _namedtuple("UserPath", fieldsUserPath);
+
+    bp::list fieldsVoxels;
+    fieldsVoxels.append("coords");
+    fieldsVoxels.append("scores");
+    fieldsVoxels.append("labels");
+    _Voxels = _namedtuple("Voxels", fieldsVoxels);
+
+    bp::list fieldsVoxelVolume;
+    fieldsVoxelVolume.append("occupancy");
+    fieldsVoxelVolume.append("labels");
+    _VoxelVolume = _namedtuple("VoxelVolume", fieldsVoxelVolume);
+
+    bp::list fieldsStreamStats;
+    fieldsStreamStats.append("delivered");
+    fieldsStreamStats.append("skipped");
+    _StreamStats = _namedtuple("StreamStats", fieldsStreamStats);
+}
+
+Nuitrack::~Nuitrack()
+{
+    // Callbacks may be running on the worker, waiting for the GIL.
+    ScopedNoGIL nogil;
+    try
+    {
+        _tracker.release();
+    }
+    catch (const NuitrackException &)
+    {
+    }
 }
 
-void Nuitrack::init(std::string configPath)
+void Nuitrack::_call(const bp::object &callable, const bp::object &data)
 {
-    // Initialize Nuitrack
     try
     {
-        nt::Nuitrack::init(configPath);
+        callable(data);
+    }
+    catch (const bp::error_already_set &)
+    {
+        if (!_tracker.inWorkerThread())
+            throw;
+        PyErr_Print();
     }
-    catch (const nt::Exception &e)
+}
+
+void Nuitrack::init(std::string configPath, std::string device)
+{
     {
-        throw NuitrackException("Could not initialize Nuitrack");
+        ScopedNoGIL nogil;
+        _tracker.init(configPath, device);
     }
+    _colorMode = _tracker.colorMode();
+}
+
+void Nuitrack::update()
+{
+    // Callbacks take the GIL back when they need it.
+    ScopedNoGIL nogil;
+    _tracker.update();
+}
+
+void Nuitrack::start()
+{
+    // Joins a worker stopped by an error, which needs the GIL to exit.
+    ScopedNoGIL nogil;
+    _tracker.start();
+}
 
-    // These two settings are required to enable face tracking.
-    nt::Nuitrack::setConfigValue("Faces.ToUse", "true");
-    nt::Nuitrack::setConfigValue("DepthProvider.Depth2ColorRegistration", "true");
+void Nuitrack::stop()
+{
+    // The worker may be waiting for the GIL to finish a callback.
+    ScopedNoGIL nogil;
+    _tracker.stop();
+}
 
-    _depthSensor = nt::DepthSensor::create();
-    _depthSensor->connectOnNewFrame(
-        std::bind(&Nuitrack::_onNewDepthFrame, this, std::placeholders::_1));
-    _outputModeDepth = _depthSensor->getOutputMode();
+bool Nuitrack::isRunning()
+{
+    return _tracker.isRunning();
+}
 
-    _colorSensor = nt::ColorSensor::create();
-    _colorSensor->connectOnNewFrame(
-        std::bind(&Nuitrack::_onNewRGBFrame, this, std::placeholders::_1));
-    _outputModeColor = _colorSensor->getOutputMode();
+std::string Nuitrack::getDeviceName()
+{
+    ScopedNoGIL nogil;
+    return _tracker.deviceName();
+}
 
-    _handTracker = nt::HandTracker::create();
-    _handTracker->connectOnUpdate(
-        std::bind(&Nuitrack::_onHandUpdate, this, std::placeholders::_1));
+void Nuitrack::setDepthCallback(bp::object callable, double rate, int every,
+                                bool onlyWithUsers, bool compressed)
+{
+    PyCallback callback = toCallback(callable);
+    ScopedNoGIL nogil;
+    if (callback && compressed)
+        _tracker.setCompressedDepthCallback(
+            [this, callback](const CompressedImage &image)
+            {
+                ScopedGIL gil;
+                _call(*callback, toBytes(image.data, image.size));
+            },
+            rate, every, onlyWithUsers);
+    else if (callback)
+        _tracker.setDepthCallback(
+            [this, callback](const DepthImage &frame)
+            {
+                ScopedGIL gil;
+                _call(*callback, toArray(frame.data, bp::make_tuple(
+                                             frame.rows, frame.cols)));
+            },
+            rate, every, onlyWithUsers);
+    else
+        _tracker.setDepthCallback(nullptr, rate, every, onlyWithUsers);
+}
 
-    _userTracker = nt::UserTracker::create();
-    _userTracker->connectOnUpdate(
-        std::bind(&Nuitrack::_onUserUpdate, this, std::placeholders::_1));
+void Nuitrack::setColorCallback(bp::object callable, double rate, int every,
+                                bool onlyWithUsers)
+{
+    PyCallback callback = toCallback(callable);
+    ColorCallback color;
+    if (callback)
+        color = [this, callback](const ColorImage &frame)
+        {
+            ScopedGIL gil;
+            _call(*callback, toArray(frame.data, bp::make_tuple(
+                                         frame.rows, frame.cols, 3)));
+        };
 
-    _skeletonTracker = nt::SkeletonTracker::create();
-    _skeletonTracker->connectOnUpdate(
-        std::bind(&Nuitrack::_onSkeletonUpdate, this, std::placeholders::_1));
+    ScopedNoGIL nogil;
+    _tracker.setColorCallback(color, rate, every, onlyWithUsers);
+}
 
-    _gestureRecognizer = nt::GestureRecognizer::create();
-    _gestureRecognizer->connectOnNewGestures(
-        std::bind(&Nuitrack::_onNewGesture, this, std::placeholders::_1));
+void Nuitrack::setSkeletonCallback(bp::object callable, double rate,
+                                   int every, bool onlyWithUsers)
+{
+    PyCallback callback = toCallback(callable);
+    SkeletonCallback skeletons;
+    if (callback)
+        skeletons = [this, callback](const SkeletonFrame &frame)
+        {
+            ScopedGIL gil;
+            _call(*callback, _getSkeletons(frame));
+        };
 
-    _onIssuesUpdateHandler = nt::Nuitrack::connectOnIssuesUpdate(
-        std::bind(&Nuitrack::_onIssuesUpdate, this, std::placeholders::_1));
+    ScopedNoGIL nogil;
+    _tracker.setSkeletonCallback(skeletons, rate, every, onlyWithUsers);
+}
 
-    // Start Nuitrack
-    try
-    {
-        nt::Nuitrack::run();
-    }
-    catch (const nt::Exception &e)
+void Nuitrack::setFaceCallback(bp::object callable, double rate, int every,
+                               bool onlyWithUsers)
+{
+    PyCallback callback = toCallback(callable);
+    FaceCallback faces;
+    if (callback)
+        faces = [this, callback](const std::string &json)
+        {
+            // Remove the quotes from the JSON file so the (un)quoted numbers
+            // can be read as int or float. Uses PyYAML for parsing.
+            std::string faceInfo = json;
+            boost::replace_all(faceInfo, "\"", "");
+            ScopedGIL gil;
+            _call(*callback, _yaml.attr("load")(faceInfo));
+        };
+
+    ScopedNoGIL nogil;
+    _tracker.setFaceCallback(faces, rate, every, onlyWithUsers);
+}
+
+void Nuitrack::setHandsCallback(bp::object callable, double rate, int every,
+                                bool onlyWithUsers)
+{
+    PyCallback callback = toCallback(callable);
+    HandsCallback hands;
+    if (callback)
+        hands = [this, callback](const HandFrame &frame)
+        {
+            ScopedGIL gil;
+            _call(*callback, _getHands(frame));
+        };
+
+    ScopedNoGIL nogil;
+    _tracker.setHandsCallback(hands, rate, every, onlyWithUsers);
+}
+
+void Nuitrack::setUserCallback(bp::object callable, double rate, int every,
+                               bool onlyWithUsers, bool compressed)
+{
+    PyCallback callback = toCallback(callable);
+    ScopedNoGIL nogil;
+    if (callback && compressed)
+        _tracker.setCompressedUserCallback(
+            [this, callback](const CompressedImage &image)
+            {
+                ScopedGIL gil;
+                _call(*callback, toBytes(image.data, image.size));
+            },
+            rate, every, onlyWithUsers);
+    else if (callback)
+        _tracker.setUserCallback(
+            [this, callback](const DepthImage &frame)
+            {
+                ScopedGIL gil;
+                _call(*callback, toArray(frame.data, bp::make_tuple(
+                                             frame.rows, frame.cols)));
+            },
+            rate, every, onlyWithUsers);
+    else
+        _tracker.setUserCallback(nullptr, rate, every, onlyWithUsers);
+}
+
+void Nuitrack::setGestureCallback(bp::object callable)
+{
+    PyCallback callback = toCallback(callable);
+    GestureCallback gestures;
+    TemplateGestureCallback matches;
+    if (callback)
     {
-        std::string msg("Nuitrack update failed: ");
-        msg += exceptionType_str[e.type()];
-        throw NuitrackException(msg);
+        gestures = [this, callback](const std::vector<GestureEvent> &events)
+        {
+            ScopedGIL gil;
+            bp::list listGest;
+            for (const GestureEvent &gest : events)
+                listGest.append(_Gesture(gest.userId,
+                                         (nt::GestureType)gest.type));
+            _call(*callback, listGest);
+        };
+
+        // Custom gestures have no type.
+        matches = [this, callback](
+            const std::vector<GestureMatcher::Match> &events)
+        {
+            ScopedGIL gil;
+            bp::list listGest;
+            for (const GestureMatcher::Match &m : events)
+                listGest.append(_Gesture(m.userId, bp::object(),
+                                         m.templateId, m.score));
+            _call(*callback, listGest);
+        };
     }
+
+    ScopedNoGIL nogil;
+    _tracker.setGestureCallback(gestures);
+    _tracker.setTemplateGestureCallback(matches);
 }
 
-void Nuitrack::update()
+void Nuitrack::setIssueCallback(bp::object callable)
 {
-    try
+    PyCallback callback = toCallback(callable);
+    IssueCallback issues;
+    if (callback)
+        issues = [this, callback](const std::vector<IssueEvent> &events)
+        {
+            ScopedGIL gil;
+            bp::list listIssues;
+            for (const IssueEvent &issue : events)
+            {
+                if (issue.occlusion)
+                    listIssues.append(_OcclusionIssue(issue.userId));
+                else
+                    listIssues.append(_FrameBorderIssue(issue.userId,
+                                                        issue.left,
+                                                        issue.right,
+                                                        issue.top));
+            }
+            _call(*callback, listIssues);
+        };
+
+    ScopedNoGIL nogil;
+    _tracker.setIssueCallback(issues);
+}
+
+bp::api::object Nuitrack::_getJointData(const JointState &joint)
+{
+    // Real coordinates are already in the output frame.
+    float fReal[] = {joint.real[0], joint.real[1], joint.real[2]};
+    float fProj[] = {joint.proj[0] * _colorMode.xres,
+                     joint.proj[1] * _colorMode.yres,
+                     joint.proj[2]};
+
+    return _Joint((nt::JointType)joint.type,
+                  joint.confidence,
+                  toArray(fReal, bp::make_tuple(3)),
+                  toArray(fProj, bp::make_tuple(3)),
+                  toArray(joint.orient, bp::make_tuple(3, 3)));
+}
+
+bp::api::object Nuitrack::_getSkeletons(const SkeletonFrame &frame)
+{
+    bp::list listSkel;
+    for (const SkeletonState &skel : frame.skeletons)
     {
-        nt::Nuitrack::waitUpdate(_skeletonTracker);
+        bp::list listJoint;
+        listJoint.append(skel.userId);
+        for (int i = 0; i < HISTORY_JOINTS; i++)
+            listJoint.append(_getJointData(skel.joints[i]));
+        listSkel.append(_Skeleton.attr("_make")(listJoint));
     }
-    catch (nt::LicenseNotAcquiredException &e)
+
+    return _SkelResult(frame.timestamp,
+                       (int)frame.skeletons.size(),
+                       listSkel);
+}
+
+bp::api::object Nuitrack::_getHandData(const HandState &hand)
+{
+    if (hand.tracked)
     {
-        throw NuitrackException("License not acquired.");
+        float fProj[] = {hand.proj[0] * _colorMode.xres,
+                         hand.proj[1] * _colorMode.yres};
+        float fReal[] = {hand.real[0], hand.real[1], hand.real[2]};
+
+        return _Hand(hand.click, hand.pressure,
+                     toArray(fProj, bp::make_tuple(2)),
+                     toArray(fReal, bp::make_tuple(3)));
     }
-    catch (const nt::Exception &e)
+    else
+        return bp::object();
+}
+
+bp::api::object Nuitrack::_getHands(const HandFrame &frame)
+{
+    bp::list listUserHands;
+    for (const UserHandsState &hands : frame.users)
     {
-        std::string msg("Nuitrack update failed: ");
-        msg += exceptionType_str[e.type()];
-        throw NuitrackException(msg);
+        auto data = _UserHands(
+            hands.userId,
+            _getHandData(hands.left),
+            _getHandData(hands.right));
+
+        listUserHands.append(data);
     }
+
+    return bp::make_tuple(frame.timestamp,
+                          (int)frame.users.size(),
+                          listUserHands);
+}
+
+void Nuitrack::setHistoryCapacity(size_t capacity)
+{
+    ScopedNoGIL nogil;
+    _tracker.setHistoryCapacity(capacity);
 }
 
-void Nuitrack::setDepthCallback(PyObject *callable)
+bp::api::object Nuitrack::getHistory(int userId, double seconds)
 {
-    _pyDepthCallback = callable;
+    std::vector<uint64_t> timestamp;
+    std::vector<float> joints;
+    std::vector<float> confidence;
+    size_t length;
+    {
+        ScopedNoGIL nogil;
+        length = _tracker.skeletonHistory(userId, seconds, timestamp, joints,
+                                          confidence);
+    }
+
+    return _History(toArray(timestamp, bp::make_tuple(length)),
+                    toArray(joints, bp::make_tuple(length, HISTORY_JOINTS, 3)),
+                    toArray(confidence, bp::make_tuple(length, HISTORY_JOINTS)));
 }
 
-void Nuitrack::setColorCallback(PyObject *callable)
+bp::api::object Nuitrack::getHandHistory(int userId, double seconds)
 {
-    _pyColorCallback = callable;
+    std::vector<uint64_t> timestamp;
+    std::vector<float> real;
+    std::vector<uint8_t> click;
+    std::vector<int32_t> pressure;
+    size_t length;
+    {
+        ScopedNoGIL nogil;
+        length = _tracker.handHistory(userId, seconds, timestamp, real, click,
+                                      pressure);
+    }
+
+    return _HandHistory(toArray(timestamp, bp::make_tuple(length)),
+                        toArray(real, bp::make_tuple(length, HISTORY_HANDS, 3)),
+                        toArray(click, bp::make_tuple(length, HISTORY_HANDS)),
+                        toArray(pressure, bp::make_tuple(length, HISTORY_HANDS)));
 }
 
-void Nuitrack::setSkeletonCallback(PyObject *callable)
+bp::list Nuitrack::getHistoryUsers()
 {
-    _pySkeletonCallback = callable;
+    std::vector<int> ids;
+    {
+        ScopedNoGIL nogil;
+        ids = _tracker.historyUsers();
+    }
+
+    bp::list users;
+    for (int userId : ids)
+        users.append(userId);
+    return users;
 }
 
-void Nuitrack::setFaceCallback(PyObject *callable)
+int Nuitrack::addGestureTemplate(bp::api::object joints, float threshold)
 {
-    _pyFaceCallback = callable;
+    np::ndarray array = np::from_object(joints).astype(_dtFloat);
+    if (array.get_nd() != 3 || array.shape(1) != HISTORY_JOINTS ||
+        array.shape(2) != 3)
+        throw NuitrackException("Gesture template must be a (T, 20, 3) array.");
+
+    // Copy through the strides, so any memory layout is accepted.
+    size_t length = array.shape(0);
+    const Py_intptr_t *strides = array.get_strides();
+    const char *data = array.get_data();
+    std::vector<float> frames(length * HISTORY_JOINTS * 3);
+    for (size_t t = 0; t < length; t++)
+        for (int j = 0; j < HISTORY_JOINTS; j++)
+            for (int k = 0; k < 3; k++)
+                frames[(t * HISTORY_JOINTS + j) * 3 + k] = *(const float *)(
+                    data + t * strides[0] + j * strides[1] + k * strides[2]);
+
+    ScopedNoGIL nogil;
+    return _tracker.addGestureTemplate(frames.data(), length, threshold);
 }
 
-void Nuitrack::setHandsCallback(PyObject *callable)
+int Nuitrack::loadGestureTemplate(std::string path, float threshold)
 {
-    _pyHandsCallback = callable;
+    return addGestureTemplate(bp::import("numpy").attr("load")(path),
+                              threshold);
 }
 
-void Nuitrack::Nuitrack::setUserCallback(PyObject *callable)
+bool Nuitrack::removeGestureTemplate(int templateId)
 {
-    _pyUserCallback = callable;
+    ScopedNoGIL nogil;
+    return _tracker.removeGestureTemplate(templateId);
 }
 
-void Nuitrack::setGestureCallback(PyObject *callable)
+void Nuitrack::clearGestureTemplates()
 {
-    _pyGestureCallback = callable;
+    ScopedNoGIL nogil;
+    _tracker.clearGestureTemplates();
 }
 
-void Nuitrack::setIssueCallback(PyObject *callable)
+void Nuitrack::setDepthFilter(int holeFill, std::string temporal, float alpha,
+                              int medianWindow, int temporalDelta,
+                              int edgeThreshold)
 {
-    _pyIssueCallback = callable;
+    DepthFilterConfig config;
+    if (temporal == "none")
+        config.temporal = TEMPORAL_NONE;
+    else if (temporal == "ema")
+        config.temporal = TEMPORAL_EMA;
+    else if (temporal == "median")
+        config.temporal = TEMPORAL_MEDIAN;
+    else
+        throw NuitrackException("Unknown temporal filter: " + temporal);
+
+    config.holeFill = holeFill;
+    config.alpha = alpha;
+    config.medianWindow = medianWindow;
+    config.temporalDelta = temporalDelta;
+    config.edgeThreshold = edgeThreshold;
+    ScopedNoGIL nogil;
+    _tracker.setDepthFilter(config);
 }
 
-void Nuitrack::_onIssuesUpdate(nt::IssuesData::Ptr issuesData)
+np::ndarray Nuitrack::filterDepth(bp::api::object depth)
 {
-    if (_pyIssueCallback && issuesData)
-    {
-        bp::list listIssues;
-        for (int userId = 0; userId < 8; userId++)
-        {
-            auto issueFB = issuesData->getUserIssue<nt::FrameBorderIssue>(userId);
-            if (issueFB)
-                listIssues.append(_FrameBorderIssue(userId, 
-                                                    issueFB->isLeft(),
-                                                    issueFB->isRight(),
-                                                    issueFB->isTop()));
-
-            auto issueOcc = issuesData->getUserIssue<nt::OcclusionIssue>(userId);
-            if (issueOcc)
-                listIssues.append(_OcclusionIssue(userId));
-        }
+    np::ndarray input = np::from_object(np::from_object(depth).astype(_dtUInt16),
+                                        2, 2, np::ndarray::C_CONTIGUOUS);
+    int nRows = input.shape(0);
+    int nCols = input.shape(1);
 
-        if (bp::len(listIssues))
-            bp::call<void>(_pyIssueCallback, listIssues);
+    np::ndarray output = np::empty(bp::make_tuple(nRows, nCols), _dtUInt16);
+    {
+        ScopedNoGIL nogil;
+        _tracker.filterDepth((const uint16_t *)input.get_data(),
+                             (uint16_t *)output.get_data(), nRows, nCols);
     }
+    return output;
 }
 
-void Nuitrack::_onNewGesture(nt::GestureData::Ptr gestureData)
+bp::dict Nuitrack::getDepthFilterStats(bool offline)
 {
-    if (_pyGestureCallback)
+    uint64_t frames;
+    double fillTemporalMs, edgeMs;
     {
-        auto gestures = gestureData->getGestures();
-        bp::list listGest;
-        for (nt::Gesture gest : gestures)
-        {
-            listGest.append(_Gesture(gest.userId, gest.type));
-        }
-        bp::call<void>(_pyGestureCallback, listGest);
+        ScopedNoGIL nogil;
+        _tracker.depthFilterStats(offline, frames, fillTemporalMs, edgeMs);
     }
+
+    bp::dict stats;
+    stats["frames"] = frames;
+    stats["fill_temporal_ms"] = fillTemporalMs;
+    stats["edge_ms"] = edgeMs;
+    return stats;
 }
 
-void Nuitrack::_onUserUpdate(nt::UserFrame::Ptr frame)
+void Nuitrack::setFloorEstimation(bool enable, int stride, double interval)
 {
-    if (_pyUserCallback != NULL)
+    ScopedNoGIL nogil;
+    _tracker.setFloorEstimation(enable, stride, interval);
+}
+
+bp::api::object Nuitrack::getFloor()
+{
+    Plane floor;
+    float confidence;
+    bool found;
     {
-        const uint16_t *depthPtr = frame->getData();
-        int nCols = frame->getCols();
-        int nRows = frame->getRows();
+        ScopedNoGIL nogil;
+        found = _tracker.floorPlane(floor, confidence);
+    }
+    if (!found)
+        return bp::object();
+
+    RigidTransform world = floor.worldTransform();
+    float matrix[16] = {world.r[0], world.r[1], world.r[2], world.t[0],
+                        world.r[3], world.r[4], world.r[5], world.t[1],
+                        world.r[6], world.r[7], world.r[8], world.t[2],
+                        0, 0, 0, 1};
 
-        np::ndarray npData = np::from_data(
-                    depthPtr, _dtUInt16,
-                    bp::make_tuple(nRows, nCols),
-                    bp::make_tuple(nCols * sizeof(uint16_t), sizeof(uint16_t)),
-                    bp::object());
+    return _Floor(toArray(floor.n, bp::make_tuple(3)),
+                  floor.d,
+                  confidence,
+                  toArray(matrix, bp::make_tuple(4, 4)));
+}
+
+void Nuitrack::setWorldFrame(bool enable)
+{
+    ScopedNoGIL nogil;
+    _tracker.setWorldFrame(enable);
+}
 
-        bp::call<void>(_pyUserCallback, npData.copy());
+np::ndarray Nuitrack::getPointCloud(int stride)
+{
+    std::vector<float> points;
+    size_t count;
+    {
+        ScopedNoGIL nogil;
+        count = _tracker.pointCloud(stride, points);
     }
+
+    return toArray(points, bp::make_tuple(count, 3));
 }
 
-bp::api::object Nuitrack::_getJointData(nt::Joint joint)
+void Nuitrack::setOccupancyGrid(float xMin, float zMin, float cellSize,
+                                int cols, int rows, std::string source)
 {
-    float fReal[] = {joint.real.x, joint.real.y, joint.real.z};
+    if (source != "torso" && source != "mask")
+        throw NuitrackException("Unknown occupancy source: " + source);
+
+    OccupancyGrid grid;
+    grid.xMin = xMin;
+    grid.zMin = zMin;
+    grid.cellSize = cellSize;
+    grid.cols = cols;
+    grid.rows = rows;
+    ScopedNoGIL nogil;
+    _tracker.setOccupancyGrid(grid, source == "mask");
+}
 
-    np::ndarray real = np::from_data(fReal, _dtFloat,
-                                     bp::make_tuple(3),
-                                     bp::make_tuple(sizeof(float)),
-                                     bp::object());
+bp::api::object Nuitrack::getOccupancy()
+{
+    OccupancyGrid grid;
+    std::vector<uint32_t> counts;
+    std::vector<float> dwell;
+    std::map<int, OccupancyMap::Track> tracks;
+    {
+        ScopedNoGIL nogil;
+        _tracker.occupancy(grid, counts, dwell, tracks);
+    }
 
-    float fProj[] = {joint.proj.x * _outputModeColor.xres,
-                     joint.proj.y * _outputModeColor.yres,
-                     joint.proj.z};
+    bp::dict users;
+    for (auto &track : tracks)
+        users[track.first] = _UserPath(track.second.pathLength,
+                                       track.second.duration);
 
-    np::ndarray proj = np::from_data(fProj, _dtFloat,
-                                     bp::make_tuple(3),
-                                     bp::make_tuple(sizeof(float)),
-                                     bp::object());
+    return _Occupancy(toArray(counts, bp::make_tuple(grid.rows, grid.cols)),
+                      toArray(dwell, bp::make_tuple(grid.rows, grid.cols)),
+                      users);
+}
 
-    np::ndarray orientation = np::from_data(
-                joint.orient.matrix, _dtFloat,
-                bp::make_tuple(3, 3),
-                bp::make_tuple(3 * sizeof(float), sizeof(float)),
-                bp::object());
+void Nuitrack::resetOccupancy()
+{
+    ScopedNoGIL nogil;
+    _tracker.resetOccupancy();
+}
 
-    return _Joint(joint.type,
-                  joint.confidence,
-                  real.copy(),
-                  proj.copy(),
-                  orientation.copy());
+void Nuitrack::setVoxelGrid(float x, float y, float z, float voxelSize,
+                            int nx, int ny, int nz, int stride, float decay,
+                            std::string storage)
+{
+    if (storage != "dense" && storage != "sparse")
+        throw NuitrackException("Unknown voxel storage: " + storage);
+
+    VoxelGridConfig config;
+    config.origin[0] = x;
+    config.origin[1] = y;
+    config.origin[2] = z;
+    config.voxelSize = voxelSize;
+    config.nx = nx;
+    config.ny = ny;
+    config.nz = nz;
+    config.stride = stride;
+    config.decay = decay;
+    config.sparse = storage == "sparse";
+    ScopedNoGIL nogil;
+    _tracker.setVoxelGrid(config);
 }
 
-void Nuitrack::_onSkeletonUpdate(nt::SkeletonData::Ptr userSkeletons)
+bp::api::object Nuitrack::getVoxels(float threshold, bool dense)
 {
-    if (_pySkeletonCallback)
+    if (dense)
     {
-        bp::list listSkel;
-        auto skeletons = userSkeletons->getSkeletons();
-        for (nt::Skeleton skel : skeletons)
+        VoxelGridConfig config;
+        std::vector<uint8_t> occupancy;
+        std::vector<uint16_t> labels;
         {
-            bp::list listJoint;
-            listJoint.append(skel.id);
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_HEAD]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_NECK]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_TORSO]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_WAIST]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_COLLAR]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_SHOULDER]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_ELBOW]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_WRIST]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_HAND]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_COLLAR]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_SHOULDER]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_ELBOW]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_WRIST]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_HAND]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_HIP]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_KNEE]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_LEFT_ANKLE]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_HIP]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_KNEE]));
-            listJoint.append(_getJointData(skel.joints[nt::JOINT_RIGHT_ANKLE]));
-            listSkel.append(_Skeleton.attr("_make")(listJoint));
+            ScopedNoGIL nogil;
+            config = _tracker.voxelGridConfig();
+            _tracker.voxelVolume(threshold, occupancy, labels);
         }
 
-        auto data = _SkelResult(
-            userSkeletons->getTimestamp(),
-            userSkeletons->getNumSkeletons(),
-            listSkel);
-
-        bp::call<void>(_pySkeletonCallback, data);
+        bp::tuple shape = bp::make_tuple(config.nz, config.ny, config.nx);
+        bp::tuple bits = bp::make_tuple(config.nz, config.ny,
+                                        (config.nx + 7) / 8);
+        return _VoxelVolume(toArray(occupancy, bits), toArray(labels, shape));
     }
 
-    if (_pyFaceCallback)
+    std::vector<int32_t> coords;
+    std::vector<float> scores;
+    std::vector<uint16_t> labels;
     {
-        std::string faceInfo = nt::Nuitrack::getInstancesJson();
-
-        // Remove the quotes from the JSON file so the (un)quoted numbers can
-        // be read as int or float. Uses PyYAML for parsing.
-        boost::replace_all(faceInfo, "\"", "");
-        bp::call<void>(_pyFaceCallback, _yaml.attr("load")(faceInfo));
+        ScopedNoGIL nogil;
+        _tracker.occupiedVoxels(threshold, coords, scores, labels);
     }
+
+    size_t count = scores.size();
+    return _Voxels(toArray(coords, bp::make_tuple(count, 3)),
+                   toArray(scores, bp::make_tuple(count)),
+                   toArray(labels, bp::make_tuple(count)));
 }
 
-void Nuitrack::_onNewDepthFrame(nt::DepthFrame::Ptr frame)
+bp::dict Nuitrack::getStreamStats()
 {
-    if (_pyDepthCallback != NULL)
+    static const char *names[STREAM_COUNT] =
+        {"depth", "color", "user", "skeleton", "face", "hands"};
+
+    uint64_t delivered[STREAM_COUNT], skipped[STREAM_COUNT];
     {
-        const uint16_t *depthPtr = frame->getData();
-        int nCols = frame->getCols();
-        int nRows = frame->getRows();
+        ScopedNoGIL nogil;
+        for (int i = 0; i < STREAM_COUNT; i++)
+            _tracker.streamStats((Stream)i, delivered[i], skipped[i]);
+    }
 
-        np::ndarray npData = np::from_data(
-                    depthPtr, _dtUInt16,
-                    bp::make_tuple(nRows, nCols),
-                    bp::make_tuple(nCols * sizeof(uint16_t), sizeof(uint16_t)),
-                    bp::object());
+    bp::dict stats;
+    for (int i = 0; i < STREAM_COUNT; i++)
+        stats[names[i]] = _StreamStats(delivered[i], skipped[i]);
+    return stats;
+}
 
-        bp::call<void>(_pyDepthCallback, npData.copy());
-    }
+void Nuitrack::setWatchdog(double timeout, int maxAttempts)
+{
+    ScopedNoGIL nogil;
+    _tracker.setWatchdog(timeout, maxAttempts);
 }
 
-void Nuitrack::_onNewRGBFrame(nt::RGBFrame::Ptr frame)
+bp::dict Nuitrack::getWatchdogStats()
 {
-    if (_pyColorCallback != NULL)
+    WatchdogStats watchdog;
     {
-        const uint8_t *colorPtr = (uint8_t *)frame->getData();
-        int nCols = frame->getCols();
-        int nRows = frame->getRows();
+        ScopedNoGIL nogil;
+        watchdog = _tracker.watchdogStats();
+    }
 
-        np::ndarray npData = np::from_data(
-            colorPtr, _dtUInt8,
-            bp::make_tuple(nRows, nCols, 3),
-            bp::make_tuple(nCols * 3 * sizeof(uint8_t), 3 * sizeof(uint8_t), sizeof(uint8_t)),
-            bp::object());
+    bp::dict stats;
+    stats["failures"] = watchdog.failures;
+    stats["stalls"] = watchdog.stalls;
+    stats["hangs"] = watchdog.hangs;
+    stats["recoveries"] = watchdog.recoveries;
+    stats["failed_recoveries"] = watchdog.failedRecoveries;
+    stats["last_recovery_ms"] = watchdog.lastRecoveryMs;
+    stats["max_recovery_ms"] = watchdog.maxRecoveryMs;
+    stats["total_recovery_ms"] = watchdog.totalRecoveryMs;
+    stats["last_error"] = watchdog.lastError.empty() ?
+                          bp::object() : bp::object(watchdog.lastError);
+    return stats;
+}
 
-        bp::call<void>(_pyColorCallback, npData.copy());
-    }
+void Nuitrack::release()
+{
+    ScopedNoGIL nogil;
+    _tracker.release();
 }
 
-bp::api::object Nuitrack::_getHandData(nt::Hand::Ptr hand)
+bp::list getDevices(std::string configPath)
 {
-    if (hand && hand->x != -1)
+    std::vector<DeviceInfo> devices;
     {
-        float fProj[] = {hand->x * _outputModeColor.xres,
-                         hand->y * _outputModeColor.yres};
-
-        np::ndarray proj = np::from_data(fProj, _dtFloat,
-                                         bp::make_tuple(2),
-                                         bp::make_tuple(sizeof(float)),
-                                         bp::object());
-
-        float fReal[] = {hand->xReal, hand->yReal, hand->zReal};
-
-        np::ndarray real = np::from_data(fReal, _dtFloat,
-                                         bp::make_tuple(3),
-                                         bp::make_tuple(sizeof(float)),
-                                         bp::object());
+        ScopedNoGIL nogil;
+        devices = listDevices(configPath);
+    }
 
-        return _Hand(hand->click, hand->pressure, proj.copy(), real.copy());
+    bp::list list;
+    for (const DeviceInfo &info : devices)
+    {
+        bp::dict device;
+        device["serial"] = info.serial;
+        device["name"] = info.name;
+        list.append(device);
     }
-    else
-        return bp::object();
+    return list;
 }
 
-// Callback for the hand data update event
-void Nuitrack::_onHandUpdate(nt::HandTrackerData::Ptr handData)
+/// FrameCodec method compressing an image.
+typedef void (FrameCodec::*CompressMethod)(const uint16_t *, int, int,
+                                           std::vector<uint8_t> &);
+
+/**
+ * @brief Compresses a 2D uint16 array with the given FrameCodec method.
+ */
+static bp::object compressImage(bp::object image, CompressMethod method)
 {
-    if (_pyHandsCallback && handData)
+    np::ndarray input = np::from_object(
+        np::from_object(image).astype(np::dtype::get_builtin<uint16_t>()),
+        2, 2, np::ndarray::C_CONTIGUOUS);
+    int nRows = input.shape(0);
+    int nCols = input.shape(1);
+
+    FrameCodec codec;
+    std::vector<uint8_t> compressed;
     {
-        bp::list listUserHands;
-
-        for (nt::UserHands hands : handData->getUsersHands())
-        {
-            auto data = _UserHands(
-                hands.userId,
-                _getHandData(hands.leftHand),
-                _getHandData(hands.rightHand));
-
-            listUserHands.append(data);
-        }
+        ScopedNoGIL nogil;
+        (codec.*method)((const uint16_t *)input.get_data(), nRows, nCols,
+                        compressed);
+    }
+    return toBytes(compressed.data(), compressed.size());
+}
 
-        auto data = bp::make_tuple(
-            handData->getTimestamp(),
-            handData->getNumUsers(),
-            listUserHands);
+bp::object compressDepth(bp::object depth)
+{
+    return compressImage(depth, &FrameCodec::compressDepth);
+}
 
-        bp::call<void>(_pyHandsCallback, data);
-    }
+bp::object compressLabels(bp::object labels)
+{
+    return compressImage(labels, &FrameCodec::compressLabels);
 }
 
-void Nuitrack::release()
+np::ndarray decompress(bp::object data)
 {
-    nt::Nuitrack::release();
+    Py_buffer buffer;
+    if (PyObject_GetBuffer(data.ptr(), &buffer, PyBUF_SIMPLE))
+        bp::throw_error_already_set();
+
+    FrameCodec codec;
+    std::vector<uint16_t> image;
+    int nRows = 0, nCols = 0;
+    bool valid;
+    {
+        ScopedNoGIL nogil;
+        valid = codec.decompress((const uint8_t *)buffer.buf, buffer.len,
+                                 image, nRows, nCols);
+    }
+    PyBuffer_Release(&buffer);
+
+    if (!valid)
+        throw NuitrackException("Invalid compressed frame");
+    return toArray(image, bp::make_tuple(nRows, nCols));
 }
 
-BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_init_overloads, Nuitrack::init, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_init_overloads, Nuitrack::init, 0, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_depth_cb_overloads, Nuitrack::setDepthCallback, 1, 5)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_color_cb_overloads, Nuitrack::setColorCallback, 1, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_skeleton_cb_overloads, Nuitrack::setSkeletonCallback, 1, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_face_cb_overloads, Nuitrack::setFaceCallback, 1, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_hands_cb_overloads, Nuitrack::setHandsCallback, 1, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_user_cb_overloads, Nuitrack::setUserCallback, 1, 5)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_history_overloads, Nuitrack::getHistory, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_hand_history_overloads, Nuitrack::getHandHistory, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_depth_filter_overloads, Nuitrack::setDepthFilter, 0, 6)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_depth_filter_stats_overloads, Nuitrack::getDepthFilterStats, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_floor_overloads, Nuitrack::setFloorEstimation, 1, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_point_cloud_overloads, Nuitrack::getPointCloud, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_occupancy_overloads, Nuitrack::setOccupancyGrid, 5, 6)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_voxel_grid_overloads, Nuitrack::setVoxelGrid, 7, 10)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_voxels_overloads, Nuitrack::getVoxels, 0, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(nt_watchdog_overloads, Nuitrack::setWatchdog, 1, 2)
+BOOST_PYTHON_FUNCTION_OVERLOADS(get_devices_overloads, getDevices, 0, 1)
 
 BOOST_PYTHON_MODULE(pynuitrack)
 {
     Py_Initialize();
     np::initialize();
+#if PY_VERSION_HEX < 0x03070000
+    // Devices can be updated by their own threads.
+    PyEval_InitThreads();
+#endif
 
     bp::register_exception_translator<NuitrackException>(&translateException);
     bp::register_exception_translator<NuitrackInitFail>(&translateException);
@@ -534,16 +1092,48 @@ BOOST_PYTHON_MODULE(pynuitrack)
         .value("right_foot", nt::JOINT_RIGHT_FOOT)
         .export_values();
 
-    bp::class_<Nuitrack>("Nuitrack", bp::init<>())
-        .def("init", &Nuitrack::init, nt_init_overloads(bp::arg("configPath") = "", "Path to the configuration file"))
+    bp::def("get_devices", getDevices, get_devices_overloads((bp::arg("config_path") = ""), "Lists the connected sensors"));
+    bp::def("compress_depth", compressDepth, "Compresses a depth image without loss");
+    bp::def("compress_labels", compressLabels, "Compresses a user label image without loss");
+    bp::def("decompress", decompress, "Decompresses a depth or user label frame");
+
+    bp::class_<Nuitrack, boost::noncopyable>("Nuitrack", bp::init<>())
+        .def("init", &Nuitrack::init, nt_init_overloads((bp::arg("configPath") = "", bp::arg("device") = ""), "Path to the configuration file and device to use"))
         .def("release", &Nuitrack::release)
-        .def("set_depth_callback", &Nuitrack::setDepthCallback)
-        .def("set_color_callback", &Nuitrack::setColorCallback)
-        .def("set_skeleton_callback", &Nuitrack::setSkeletonCallback)
-        .def("set_face_callback", &Nuitrack::setFaceCallback)
-        .def("set_hands_callback", &Nuitrack::setHandsCallback)
-        .def("set_user_callback", &Nuitrack::setUserCallback)
+        .def("start", &Nuitrack::start)
+        .def("stop", &Nuitrack::stop)
+        .def("is_running", &Nuitrack::isRunning)
+        .def("get_device_name", &Nuitrack::getDeviceName)
+        .def("set_depth_callback", &Nuitrack::setDepthCallback, nt_depth_cb_overloads((bp::arg("callable"), bp::arg("rate") = 0.0, bp::arg("every") = 1, bp::arg("only_with_users") = false, bp::arg("compressed") = false), "Sets the depth callback"))
+        .def("set_color_callback", &Nuitrack::setColorCallback, nt_color_cb_overloads((bp::arg("callable"), bp::arg("rate") = 0.0, bp::arg("every") = 1, bp::arg("only_with_users") = false), "Sets the color callback"))
+        .def("set_skeleton_callback", &Nuitrack::setSkeletonCallback, nt_skeleton_cb_overloads((bp::arg("callable"), bp::arg("rate") = 0.0, bp::arg("every") = 1, bp::arg("only_with_users") = false), "Sets the skeleton callback"))
+        .def("set_face_callback", &Nuitrack::setFaceCallback, nt_face_cb_overloads((bp::arg("callable"), bp::arg("rate") = 0.0, bp::arg("every") = 1, bp::arg("only_with_users") = false), "Sets the face callback"))
+        .def("set_hands_callback", &Nuitrack::setHandsCallback, nt_hands_cb_overloads((bp::arg("callable"), bp::arg("rate") = 0.0, bp::arg("every") = 1, bp::arg("only_with_users") = false), "Sets the hands callback"))
+        .def("set_user_callback", &Nuitrack::setUserCallback, nt_user_cb_overloads((bp::arg("callable"), bp::arg("rate") = 0.0, bp::arg("every") = 1, bp::arg("only_with_users") = false, bp::arg("compressed") = false), "Sets the user callback"))
         .def("set_gesture_callback", &Nuitrack::setGestureCallback)
         .def("set_issue_callback", &Nuitrack::setIssueCallback)
+        .def("set_history_capacity", &Nuitrack::setHistoryCapacity)
+        .def("get_history", &Nuitrack::getHistory, nt_history_overloads((bp::arg("user_id"), bp::arg("seconds") = -1), "Skeleton history of a user"))
+        .def("get_hand_history", &Nuitrack::getHandHistory, nt_hand_history_overloads((bp::arg("user_id"), bp::arg("seconds") = -1), "Hand history of a user"))
+        .def("get_history_users", &Nuitrack::getHistoryUsers)
+        .def("add_gesture_template", &Nuitrack::addGestureTemplate)
+        .def("load_gesture_template", &Nuitrack::loadGestureTemplate)
+        .def("remove_gesture_template", &Nuitrack::removeGestureTemplate)
+        .def("clear_gesture_templates", &Nuitrack::clearGestureTemplates)
+        .def("set_depth_filter", &Nuitrack::setDepthFilter, nt_depth_filter_overloads((bp::arg("hole_fill") = 0, bp::arg("temporal") = "none", bp::arg("alpha") = 0.4f, bp::arg("median_window") = 3, bp::arg("temporal_delta") = 100, bp::arg("edge_threshold") = 0), "Configures the depth filters"))
+        .def("filter_depth", &Nuitrack::filterDepth)
+        .def("get_depth_filter_stats", &Nuitrack::getDepthFilterStats, nt_depth_filter_stats_overloads((bp::arg("offline") = false), "Statistics of the depth stream or of filter_depth"))
+        .def("set_floor_estimation", &Nuitrack::setFloorEstimation, nt_floor_overloads((bp::arg("enable"), bp::arg("stride") = 8, bp::arg("interval") = 1.0), "Starts or stops the floor estimation"))
+        .def("get_floor", &Nuitrack::getFloor)
+        .def("set_world_frame", &Nuitrack::setWorldFrame)
+        .def("get_point_cloud", &Nuitrack::getPointCloud, nt_point_cloud_overloads((bp::arg("stride") = 1), "Back-projects the latest depth frame"))
+        .def("set_occupancy_grid", &Nuitrack::setOccupancyGrid, nt_occupancy_overloads((bp::arg("x_min"), bp::arg("z_min"), bp::arg("cell_size"), bp::arg("cols"), bp::arg("rows"), bp::arg("source") = "torso"), "Sets the floor grid of the occupancy map"))
+        .def("get_occupancy", &Nuitrack::getOccupancy)
+        .def("reset_occupancy", &Nuitrack::resetOccupancy)
+        .def("set_voxel_grid", &Nuitrack::setVoxelGrid, nt_voxel_grid_overloads((bp::arg("x"), bp::arg("y"), bp::arg("z"), bp::arg("voxel_size"), bp::arg("nx"), bp::arg("ny"), bp::arg("nz"), bp::arg("stride") = 2, bp::arg("decay") = 0.0f, bp::arg("storage") = "dense"), "Sets the voxel grid"))
+        .def("get_voxels", &Nuitrack::getVoxels, nt_voxels_overloads((bp::arg("threshold") = 1.0f, bp::arg("dense") = false), "Returns the occupied voxels"))
+        .def("get_stream_stats", &Nuitrack::getStreamStats)
+        .def("set_watchdog", &Nuitrack::setWatchdog, nt_watchdog_overloads((bp::arg("timeout"), bp::arg("max_attempts") = 5), "Re-initializes the device when it fails or stalls"))
+        .def("get_watchdog_stats", &Nuitrack::getWatchdogStats)
         .def("update", &Nuitrack::update);
 };
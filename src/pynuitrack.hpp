@@ -35,7 +35,9 @@
 
 #include <boost/python.hpp>
 #include <boost/python/numpy.hpp>
-#include <nuitrack/Nuitrack.h>
+#include <string>
+
+#include "tracker.hpp"
 
 /**
  * @brief Provides access to the Nuitrack library.
@@ -43,60 +45,30 @@
  * This is the main class for pynuitrack. It manages the callbacks for the depth
  * image, color image (BGR), user tracker, skeleton tracker, hand tracker and
  * gesture recognizer.
+ * 
+ * It is a thin adapter over Tracker, which does all the native processing:
+ * this class only converts the typed frames to Python objects and the
+ * arguments of its methods to the Tracker API.
+ * 
+ * Each object drives its own Device, so several sensors can be used by the
+ * same process. Data is processed without the GIL, which is only taken to
+ * build the Python objects given to the callbacks.
  */
 class Nuitrack
 {
 private:
-    /// Stores the output mode for the depth image.
-    tdv::nuitrack::OutputMode _outputModeDepth;
-
-    /// Stores the output mode for the color image.
-    tdv::nuitrack::OutputMode _outputModeColor;
-
-    /// Handler for the depth image interface.
-    tdv::nuitrack::DepthSensor::Ptr _depthSensor;
-
-    /// Handler for the color image interface.
-    tdv::nuitrack::ColorSensor::Ptr _colorSensor;
-
-    /// Handler for the user tracker interface.
-    tdv::nuitrack::UserTracker::Ptr _userTracker;
-
-    /// Handler for the skeleton tracker interface.
-    tdv::nuitrack::SkeletonTracker::Ptr _skeletonTracker;
-    
-    /// Handler for the hand tracker interface.
-    tdv::nuitrack::HandTracker::Ptr _handTracker;
-
-    /// Handler for the gesture recognizer interface.
-    tdv::nuitrack::GestureRecognizer::Ptr _gestureRecognizer;
-
-    /// Handler for the user tracker interface.
-    uint64_t _onIssuesUpdateHandler;
+    /// Native core driving the device.
+    Tracker _tracker;
 
-    /// Python callback for the depth image.
-    PyObject *_pyDepthCallback;
+    /// Output mode of the color image, used to scale projections.
+    StreamMode _colorMode;
 
-    /// Python callback for the color image.
-    PyObject *_pyColorCallback;
+    /// GIL state of the worker thread, taken when it starts.
+    PyGILState_STATE _workerGIL;
 
-    /// Python callback for the skeleton tracking.
-    PyObject *_pySkeletonCallback;
-
-    /// Python callback for the skeleton tracking.
-    PyObject *_pyFaceCallback;
-
-    /// Python callback for the hand tracking.
-    PyObject *_pyHandsCallback;
-
-    /// Python callback for the user tracking.
-    PyObject *_pyUserCallback;
-
-    /// Python callback for the gesture tracking.
-    PyObject *_pyGestureCallback;
-
-    /// Python callback for the issue handler.
-    PyObject *_pyIssueCallback;
+    /// Python thread state of the worker thread, kept for its whole life so
+    /// errors raised by the callbacks are still set when they are printed.
+    PyThreadState *_workerState;
 
     /// Numpy representation of the uint8_t type.
     boost::python::numpy::dtype _dtUInt8 =
@@ -143,90 +115,96 @@ private:
     /// Named tuple "FrameBorderIssue", used by occlusion tracking.
     boost::python::api::object _OcclusionIssue;
 
-    /**
-     * @brief Callback method for the issue tracker.
-     * 
-     * @param issuesData 
-     */
-    void _onIssuesUpdate(tdv::nuitrack::IssuesData::Ptr issuesData);
+    /// Named tuple "History", used by the trajectory history.
+    boost::python::api::object _History;
 
-    /**
-     * @brief Callback method for the gesture recognizer.
-     * 
-     * @param gestureData 
-     */
-    void _onNewGesture(tdv::nuitrack::GestureData::Ptr gestureData);
+    /// Named tuple "HandHistory", used by the trajectory history.
+    boost::python::api::object _HandHistory;
 
-    /**
-     * @brief Callback method for the user tracker.
-     * 
-     * @param frame 
-     */
-    void _onUserUpdate(tdv::nuitrack::UserFrame::Ptr frame);
+    /// Named tuple "Occupancy", used by the occupancy map.
+    boost::python::api::object _Occupancy;
 
-    /**
-     * @brief Callback method for the skeleton tracker.
-     * 
-     * @param userSkeletons 
-     */
-    void _onSkeletonUpdate(tdv::nuitrack::SkeletonData::Ptr userSkeletons);
+    /// Named tuple "UserPath", used by the occupancy map.
+    boost::python::api::object _UserPath;
 
-    /**
-     * @brief Callback method for the depth sensor.
-     * 
-     * @param frame 
-     */
-    void _onNewDepthFrame(tdv::nuitrack::DepthFrame::Ptr frame);
+    /// Named tuple "Voxels", used by the voxel grid.
+    boost::python::api::object _Voxels;
+
+    /// Named tuple "VoxelVolume", used by the voxel grid.
+    boost::python::api::object _VoxelVolume;
+
+    /// Named tuple "StreamStats", used by the stream gates.
+    boost::python::api::object _StreamStats;
+
+    /// Named tuple "Floor", used by the floor estimation.
+    boost::python::api::object _Floor;
 
     /**
-     * @brief Callback method for the color camera.
+     * @brief Calls a Python callback. Must hold the GIL.
+     * 
+     * Errors raised by the callback are printed when it is called by the
+     * worker thread, and propagated to update() otherwise.
      * 
-     * @param frame 
+     * @param callable Python callback.
+     * @param data Argument of the callback.
      */
-    void _onNewRGBFrame(tdv::nuitrack::RGBFrame::Ptr frame);
+    void _call(const boost::python::api::object &callable,
+               const boost::python::api::object &data);
 
     /**
-     * @brief Callback method for the hand tracker.
+     * @brief Converts a hand state to a python named tuple.
      * 
-     * @param handData 
+     * @param hand Hand state.
+     * @return boost::python::api::object A named tuple with the same
+     *      information as the input parameter, or None if not tracked.
      */
-    void _onHandUpdate(tdv::nuitrack::HandTrackerData::Ptr handData);
+    boost::python::api::object _getHandData(const HandState &hand);
 
     /**
-     * @brief Converts a Nuitrack Hand type to a python named tuple.
+     * @brief Converts a joint state to a python named tuple.
      * 
-     * @param hand Hand object with the information of the given hand.
+     * @param joint State of a given skeleton joint.
      * @return boost::python::api::object A named tuple with the same
      *      information as the input parameter.
      */
-    boost::python::api::object _getHandData(tdv::nuitrack::Hand::Ptr hand);
+    boost::python::api::object _getJointData(const JointState &joint);
 
     /**
-     * @brief Converts a Nuitrack joint to a python named tuple.
-     * 
-     * @param joint Joint object with the information of a given skeleton joint.
-     * @return boost::python::api::object A named tuple with the same
-     *      information as the input parameter.
+     * @brief Converts the tracked skeletons to a "SkeletonResult" tuple.
      */
-    boost::python::api::object _getJointData(tdv::nuitrack::Joint joint);
+    boost::python::api::object _getSkeletons(const SkeletonFrame &frame);
+
+    /**
+     * @brief Converts the tracked hands to a (timestamp, count, hands)
+     *      tuple.
+     */
+    boost::python::api::object _getHands(const HandFrame &frame);
 
 public:
     /**
      * @brief Construct a new Nuitrack object.
      * 
-     * Sets the python callbacks to Null and initializes the Python named
-     * tuples.
+     * Initializes the Python named tuples.
      */
     Nuitrack();
 
+    /**
+     * @brief Destroy the Nuitrack object, stopping and releasing its device.
+     */
+    ~Nuitrack();
+
     /**
      * @brief Python constructor for a new Nuitrack object.
      * 
      * This should be called before using any of the other methods.
      * 
      * @param configPath Path to Nuitrack configuration file.
+     * @param device Empty for the default sensor, a sensor serial number
+     *      (see getDevices()), or "sim[:fps[:users[:faults]]]" for a
+     *      simulated device, where faults (e.g., "fail=300,stall=500")
+     *      makes it fail or stall after that many updates.
      */
-    void init(std::string configPath = "");
+    void init(std::string configPath = "", std::string device = "");
 
     /**
      * @brief Updates data from all Nuitrack modules and feed them to callbacks.
@@ -237,6 +215,31 @@ public:
      */
     void update();
 
+    /**
+     * @brief Starts a thread that updates the device continuously.
+     * 
+     * Callbacks are then called from that thread, so each device is updated
+     * independently of the others and of the Python main thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops the thread started by start().
+     * 
+     * Raises the error that stopped the thread, if any.
+     */
+    void stop();
+
+    /**
+     * @brief Returns whether the thread started by start() is running.
+     */
+    bool isRunning();
+
+    /**
+     * @brief Returns a description of the device.
+     */
+    std::string getDeviceName();
+
     /**
      * @brief Stops data processing and destroy all Nuitrack modules.
      */
@@ -245,95 +248,366 @@ public:
     /**
      * @brief Set the Python depth sensor callback.
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     * @param compressed Whether to deliver the frames compressed with
+     *      FrameCodec (as bytes, see decompress()) instead of as arrays.
      */
-    void setDepthCallback(PyObject *callable);
+    void setDepthCallback(boost::python::api::object callable,
+                          double rate = 0, int every = 1,
+                          bool onlyWithUsers = false,
+                          bool compressed = false);
 
     /**
      * @brief Set the Python color camera callback.
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
      */
-    void setColorCallback(PyObject *callable);
+    void setColorCallback(boost::python::api::object callable,
+                          double rate = 0, int every = 1,
+                          bool onlyWithUsers = false);
 
     /**
      * @brief Set the Python skeleton-tracker callback.
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
      */
-    void setSkeletonCallback(PyObject *callable);
+    void setSkeletonCallback(boost::python::api::object callable,
+                             double rate = 0, int every = 1,
+                             bool onlyWithUsers = false);
 
     /**
      * @brief Set the Python face-tracker callback.
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
      */
-    void setFaceCallback(PyObject *callable);
+    void setFaceCallback(boost::python::api::object callable,
+                         double rate = 0, int every = 1,
+                         bool onlyWithUsers = false);
 
     /**
      * @brief Set the Python hand-tracker callback.
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
      */
-    void setHandsCallback(PyObject *callable);
+    void setHandsCallback(boost::python::api::object callable,
+                          double rate = 0, int every = 1,
+                          bool onlyWithUsers = false);
 
     /**
      * @brief Set the Python user-tracker callback.
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     * @param compressed Whether to deliver the frames compressed with
+     *      FrameCodec (as bytes, see decompress()) instead of as arrays.
      */
-    void setUserCallback(PyObject *callable);
+    void setUserCallback(boost::python::api::object callable,
+                         double rate = 0, int every = 1,
+                         bool onlyWithUsers = false,
+                         bool compressed = false);
 
     /**
      * @brief Set the Python gesture-tracker callback .
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
      */
-    void setGestureCallback(PyObject *callable);
+    void setGestureCallback(boost::python::api::object callable);
 
     /**
      * @brief Set the Python color camera callback 
      * 
-     * @param callable A Python function.
+     * @param callable A Python function, or None to clear the callback.
      */
-    void setIssueCallback(PyObject *callable);
-};
+    void setIssueCallback(boost::python::api::object callable);
 
-/**
- * @brief General exception class.
- */
-class NuitrackException : public std::exception
-{
-private:
-    /// Message describing the error.
-    std::string message;
+    /**
+     * @brief Sets how many samples of trajectory history are kept per user.
+     * 
+     * Skeleton and hand data are recorded on every update, and the history of
+     * a user is dropped when the user tracker loses it.
+     * 
+     * @param capacity Number of samples per user. Zero disables the history.
+     */
+    void setHistoryCapacity(size_t capacity);
 
-public:
     /**
-     * @brief Construct a new Nuitrack Exception object.
+     * @brief Returns the skeleton history of a user.
      * 
-     * @param message String describing the error.
+     * @param userId ID of the user.
+     * @param seconds Length of the window. Negative values return everything.
+     * @return boost::python::api::object Named tuple "History" with the
+     *      timestamps (T), joint positions (T, J, 3) and confidences (T, J),
+     *      oldest first. Joints follow the order of the "Skeleton" tuple.
      */
-    NuitrackException(std::string message);
+    boost::python::api::object getHistory(int userId, double seconds = -1);
 
     /**
-     * @brief Returns the message with the error description.
+     * @brief Returns the hand history of a user.
      * 
-     * @return const char* C-string with the error description.
+     * @param userId ID of the user.
+     * @param seconds Length of the window. Negative values return everything.
+     * @return boost::python::api::object Named tuple "HandHistory" with the
+     *      timestamps (T), real positions (T, 2, 3), clicks (T, 2) and
+     *      pressures (T, 2), oldest first. Untracked hands are NaN.
      */
-    const char *what() const throw();
+    boost::python::api::object getHandHistory(int userId, double seconds = -1);
 
     /**
-     * @brief Destroy the Nuitrack Exception object.
+     * @brief Returns the IDs of the users with recorded history.
+     * 
+     * @return boost::python::list List of user IDs.
      */
-    ~NuitrackException() throw();
-};
+    boost::python::list getHistoryUsers();
 
-/**
- * @brief Exception used when pynuitrack fails to be initialized.
- */
-class NuitrackInitFail : public NuitrackException
-{
+    /**
+     * @brief Registers a custom gesture template.
+     * 
+     * Custom gestures are reported to the gesture callback as "Gesture"
+     * tuples whose type is None, along with the template ID and the score.
+     * 
+     * @param joints Array (T, J, 3) with the joint positions of the gesture,
+     *      in the same format returned by getHistory().
+     * @param threshold Maximum score accepted as a match.
+     * @return int ID of the template.
+     */
+    int addGestureTemplate(boost::python::api::object joints, float threshold);
+
+    /**
+     * @brief Registers a custom gesture template stored in a numpy file.
+     * 
+     * @param path Path to a ".npy" file with a (T, J, 3) array.
+     * @param threshold Maximum score accepted as a match.
+     * @return int ID of the template.
+     */
+    int loadGestureTemplate(std::string path, float threshold);
+
+    /**
+     * @brief Removes a custom gesture template.
+     * 
+     * @param templateId ID of the template.
+     * @return true if the template existed.
+     */
+    bool removeGestureTemplate(int templateId);
+
+    /**
+     * @brief Removes all custom gesture templates.
+     */
+    void clearGestureTemplates();
+
+    /**
+     * @brief Configures the filters applied to depth frames.
+     * 
+     * Filters run natively before the depth frame is given to the depth
+     * callback. Changing the configuration resets the temporal state.
+     * 
+     * @param holeFill Largest run of missing pixels filled in each row
+     *      (0 disables).
+     * @param temporal Temporal filter: "none", "ema" or "median".
+     * @param alpha Weight of the new frame for the "ema" filter.
+     * @param medianWindow Number of frames for the "median" filter (3 or 5).
+     * @param temporalDelta Depth jump (mm) that resets the "ema" filter.
+     * @param edgeThreshold Largest depth difference (mm) smoothed by the
+     *      edge-preserving filter (0 disables).
+     */
+    void setDepthFilter(int holeFill = 0, std::string temporal = "none",
+                        float alpha = 0.4f, int medianWindow = 3,
+                        int temporalDelta = 100, int edgeThreshold = 0);
+
+    /**
+     * @brief Applies the depth filters to an arbitrary depth image.
+     * 
+     * Meant for offline processing and benchmarking. Uses the configuration
+     * of the depth stream but its own temporal state, which carries over
+     * between calls of this method only.
+     * 
+     * @param depth 2D uint16 array, in millimeters.
+     * @return boost::python::numpy::ndarray Filtered depth image.
+     */
+    boost::python::numpy::ndarray filterDepth(boost::python::api::object depth);
+
+    /**
+     * @brief Returns the statistics of the depth filters.
+     * 
+     * @param offline Whether to return the statistics of filterDepth()
+     *      instead of those of the depth stream.
+     * @return boost::python::dict Number of filtered frames and total time
+     *      (ms) spent on the hole filling/temporal pass and on the
+     *      edge-preserving pass.
+     */
+    boost::python::dict getDepthFilterStats(bool offline = false);
+
+    /**
+     * @brief Starts or stops estimating the floor plane.
+     * 
+     * The floor is fitted on a background thread, using a subsampled depth
+     * frame at most once per interval.
+     * 
+     * @param enable Whether to estimate the floor.
+     * @param stride Pixel stride used to subsample the depth frames.
+     * @param interval Minimum time between two fits, in seconds.
+     */
+    void setFloorEstimation(bool enable, int stride = 8, double interval = 1.0);
+
+    /**
+     * @brief Returns the current floor estimate.
+     * 
+     * @return boost::python::api::object Named tuple "Floor" with the plane
+     *      normal and offset (n.p + d = 0, in the camera frame), its
+     *      confidence and the 4x4 camera-to-world transform, or None if
+     *      the floor was not found yet.
+     */
+    boost::python::api::object getFloor();
+
+    /**
+     * @brief Sets whether 3D data is given in the world frame.
+     * 
+     * The world frame has its origin on the floor right below the sensor, y
+     * pointing up and z along the sensor's viewing direction. It applies to
+     * joint positions and orientations, hands, history and point clouds. Data
+     * stays in the camera frame until the floor is found.
+     * 
+     * @param enable Whether to use the world frame.
+     */
+    void setWorldFrame(bool enable);
+
+    /**
+     * @brief Back-projects the latest depth frame.
+     * 
+     * @param stride Pixel stride used to subsample the depth frame.
+     * @return boost::python::numpy::ndarray Array (N, 3) with the real
+     *      coordinates of all valid pixels.
+     */
+    boost::python::numpy::ndarray getPointCloud(int stride = 1);
+
+    /**
+     * @brief Sets the floor grid of the occupancy map and clears it.
+     * 
+     * Users are located on the floor by their torso joint or by the centroid
+     * of their mask, in the world frame once the floor is found (the camera
+     * x/z plane otherwise). The cells are cleared when the floor is first
+     * found, so they never mix both frames.
+     * 
+     * @param xMin Position (mm) of the grid's first column, along x.
+     * @param zMin Position (mm) of the grid's first row, along z.
+     * @param cellSize Side of each cell, in millimeters.
+     * @param cols Number of cells along x. Zero disables the map.
+     * @param rows Number of cells along z. Zero disables the map.
+     * @param source How users are located: "torso" or "mask".
+     */
+    void setOccupancyGrid(float xMin, float zMin, float cellSize, int cols,
+                          int rows, std::string source = "torso");
+
+    /**
+     * @brief Returns a snapshot of the occupancy map.
+     * 
+     * @return boost::python::api::object Named tuple "Occupancy" with the
+     *      number of samples (rows, cols) and the dwell time in seconds
+     *      (rows, cols) of each cell, and a dictionary with the "UserPath"
+     *      (path length in mm and duration in s) of each tracked user.
+     */
+    boost::python::api::object getOccupancy();
+
+    /**
+     * @brief Clears the occupancy map, keeping its grid.
+     */
+    void resetOccupancy();
+
+    /**
+     * @brief Sets the voxel grid built from the depth stream and clears it.
+     * 
+     * Coordinates are in the world frame once the floor is found (the camera
+     * frame otherwise). Voxels are labeled with the users of the latest user
+     * frame.
+     * 
+     * @param x Position (mm) of the grid corner along x.
+     * @param y Position (mm) of the grid corner along y.
+     * @param z Position (mm) of the grid corner along z.
+     * @param voxelSize Side of each voxel, in millimeters.
+     * @param nx Number of voxels along x. Zero disables the grid.
+     * @param ny Number of voxels along y. Zero disables the grid.
+     * @param nz Number of voxels along z. Zero disables the grid.
+     * @param stride Pixel stride used to subsample the depth frames.
+     * @param decay Fraction of each voxel score kept from one frame to the
+     *      next. 0 keeps only the latest frame, 1 accumulates forever.
+     * @param storage "dense" (array) or "sparse" (hash map).
+     */
+    void setVoxelGrid(float x, float y, float z, float voxelSize, int nx,
+                      int ny, int nz, int stride = 2, float decay = 0,
+                      std::string storage = "dense");
+
+    /**
+     * @brief Returns the occupied voxels.
+     * 
+     * @param threshold Minimum score of an occupied voxel.
+     * @param dense Whether to return dense volumes instead of a list.
+     * @return boost::python::api::object Named tuple "Voxels" with the
+     *      coordinates (N, 3), scores (N) and labels (N) of the occupied
+     *      voxels or, if dense, named tuple "VoxelVolume" with the occupancy
+     *      bits (nz, ny, ceil(nx / 8)) and labels (nz, ny, nx) of all
+     *      voxels. The bits are packed along x like numpy.packbits, so
+     *      numpy.unpackbits(occupancy, axis=-1)[..., :nx] gives one value
+     *      per voxel.
+     */
+    boost::python::api::object getVoxels(float threshold = 1,
+                                         bool dense = false);
+
+    /**
+     * @brief Returns the delivery statistics of the Python streams.
+     * 
+     * @return boost::python::dict Named tuple "StreamStats" (delivered and
+     *      skipped frames) of each stream, indexed by the stream name.
+     */
+    boost::python::dict getStreamStats();
+
+    /**
+     * @brief Enables the watchdog of the device.
+     * 
+     * A device whose update fails, or that gives no data for longer than the
+     * timeout, is released and initialized again (only the release/init/run
+     * sequence of the SDK). Callbacks, configuration, the occupancy cells
+     * and the voxel grid are kept. Tracked users are lost, which drops their
+     * history, gesture windows and occupancy paths, since the device
+     * restarts its user IDs and timestamps.
+     * 
+     * An update still blocked after the timeout is counted as a hang. A
+     * simulated device is then interrupted and recovered, but a sensor is
+     * only recovered once the SDK returns, as it cannot be interrupted.
+     * While several sensors are in use, they share the SDK session, so a
+     * recovery only recreates the modules of the sensor.
+     * 
+     * @param timeout Longest time without data, in seconds, counting only
+     *      the time spent inside update(). Zero disables the watchdog, so
+     *      errors are raised by update() and stop().
+     * @param maxAttempts Re-initializations tried before giving up and
+     *      raising the error.
+     */
+    void setWatchdog(double timeout, int maxAttempts = 5);
+
+    /**
+     * @brief Returns the statistics of the watchdog.
+     * 
+     * @return boost::python::dict Number of failures, stalls, hangs,
+     *      recoveries and failed recoveries, the duration (ms) of the last, longest and all
+     *      recoveries, and the error that triggered the last one (or None).
+     */
+    boost::python::dict getWatchdogStats();
 };
 
 /**
@@ -344,19 +618,37 @@ class NuitrackInitFail : public NuitrackException
 void translateException(NuitrackException const &e);
 
 /**
- * @brief Translates a Nuitrack error code into a error message.
+ * @brief Lists the sensors connected to the computer.
+ * 
+ * @param configPath Path to Nuitrack configuration file.
+ * @return boost::python::list Dictionary with the serial number and name of
+ *      each sensor.
  */
-const char *exceptionType_str[] =
-{
-    "OK",
-    "Exception",
-    "Terminated",
-    "Bad configuration value",
-    "Configuration not found",
-    "Module not found",
-    "License not acquired",
-    "Module not initialized",
-    "Module not started"
-};
+boost::python::list getDevices(std::string configPath = "");
+
+/**
+ * @brief Compresses a depth image without loss.
+ * 
+ * @param depth 2D uint16 array, in millimeters.
+ * @return boost::python::api::object Compressed frame, as bytes.
+ */
+boost::python::api::object compressDepth(boost::python::api::object depth);
+
+/**
+ * @brief Compresses a user label image without loss.
+ * 
+ * @param labels 2D uint16 array.
+ * @return boost::python::api::object Compressed frame, as bytes.
+ */
+boost::python::api::object compressLabels(boost::python::api::object labels);
+
+/**
+ * @brief Decompresses a frame produced by compressDepth(), compressLabels()
+ *      or a compressed callback.
+ * 
+ * @param data Compressed frame (any object supporting the buffer protocol).
+ * @return boost::python::numpy::ndarray Decompressed 2D uint16 array.
+ */
+boost::python::numpy::ndarray decompress(boost::python::api::object data);
 
-#endif
\ No newline at end of file
+#endif
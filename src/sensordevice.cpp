@@ -0,0 +1,471 @@
+/**
+ * @file sensordevice.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the Device backed by a Nuitrack sensor.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "sensordevice.hpp"
+#include "exception.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace nt = tdv::nuitrack;
+
+/// Joints reported for each skeleton, in the order of the "Skeleton" tuple.
+static const nt::JointType skeletonJoints[SKELETON_JOINTS] =
+{
+    nt::JOINT_HEAD,
+    nt::JOINT_NECK,
+    nt::JOINT_TORSO,
+    nt::JOINT_WAIST,
+    nt::JOINT_LEFT_COLLAR,
+    nt::JOINT_LEFT_SHOULDER,
+    nt::JOINT_LEFT_ELBOW,
+    nt::JOINT_LEFT_WRIST,
+    nt::JOINT_LEFT_HAND,
+    nt::JOINT_RIGHT_COLLAR,
+    nt::JOINT_RIGHT_SHOULDER,
+    nt::JOINT_RIGHT_ELBOW,
+    nt::JOINT_RIGHT_WRIST,
+    nt::JOINT_RIGHT_HAND,
+    nt::JOINT_LEFT_HIP,
+    nt::JOINT_LEFT_KNEE,
+    nt::JOINT_LEFT_ANKLE,
+    nt::JOINT_RIGHT_HIP,
+    nt::JOINT_RIGHT_KNEE,
+    nt::JOINT_RIGHT_ANKLE
+};
+
+/// Serializes the SDK calls that are shared by all sensors.
+static std::mutex sessionMutex;
+
+/// Number of SensorDevice objects (and queries) using the SDK.
+static int sessionUsers = 0;
+
+/// Whether the SDK was started.
+static bool sessionRunning = false;
+
+/**
+ * @brief Initializes the SDK if this is its first user. Expects the session
+ *      lock to be held.
+ */
+static void enterSession(const std::string &configPath)
+{
+    if (!sessionUsers)
+    {
+        try
+        {
+            nt::Nuitrack::init(configPath);
+        }
+        catch (const nt::Exception &e)
+        {
+            throw NuitrackException("Could not initialize Nuitrack");
+        }
+
+        // These two settings are required to enable face tracking.
+        nt::Nuitrack::setConfigValue("Faces.ToUse", "true");
+        nt::Nuitrack::setConfigValue("DepthProvider.Depth2ColorRegistration",
+                                     "true");
+    }
+    sessionUsers++;
+}
+
+/**
+ * @brief Releases the SDK if this was its last user. Expects the session
+ *      lock to be held.
+ */
+static void leaveSession()
+{
+    if (--sessionUsers == 0)
+    {
+        sessionRunning = false;
+        nt::Nuitrack::release();
+    }
+}
+
+/**
+ * @brief Converts a Nuitrack hand to a HandState.
+ */
+static void toHandState(nt::Hand::Ptr hand, HandState &state)
+{
+    state.tracked = hand && hand->x != -1;
+    if (!state.tracked)
+        return;
+
+    state.proj[0] = hand->x;
+    state.proj[1] = hand->y;
+    state.click = hand->click;
+    state.pressure = hand->pressure;
+    state.real[0] = hand->xReal;
+    state.real[1] = hand->yReal;
+    state.real[2] = hand->zReal;
+}
+
+SensorDevice::SensorDevice(const std::string &serial,
+                           const std::string &configPath)
+    : _serial(serial), _configPath(configPath), _sink(NULL),
+      _initialized(false)
+{
+}
+
+SensorDevice::~SensorDevice()
+{
+    release();
+}
+
+void SensorDevice::_selectSensor()
+{
+    if (_serial.empty())
+        return;
+
+    for (nt::device::NuitrackDevice::Ptr device : nt::Nuitrack::getDeviceList())
+    {
+        if (device->getInfo(nt::device::DeviceInfoType::SERIAL_NUMBER) ==
+            _serial)
+        {
+            nt::Nuitrack::setDevice(device);
+            return;
+        }
+    }
+    throw NuitrackException("Sensor not found: " + _serial);
+}
+
+void SensorDevice::init(FrameSink *sink)
+{
+    if (_initialized)
+        throw NuitrackException("Device is already initialized.");
+
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    enterSession(_configPath);
+    _sink = sink;
+
+    try
+    {
+        _selectSensor();
+
+        _depthSensor = nt::DepthSensor::create();
+        _depthHandler = _depthSensor->connectOnNewFrame(std::bind(
+            &SensorDevice::_onNewDepthFrame, this, std::placeholders::_1));
+        nt::OutputMode mode = _depthSensor->getOutputMode();
+        _depthMode.xres = mode.xres;
+        _depthMode.yres = mode.yres;
+        _depthMode.fps = mode.fps;
+        _depthMode.hfov = mode.hfov;
+
+        _colorSensor = nt::ColorSensor::create();
+        _colorHandler = _colorSensor->connectOnNewFrame(std::bind(
+            &SensorDevice::_onNewRGBFrame, this, std::placeholders::_1));
+        mode = _colorSensor->getOutputMode();
+        _colorMode.xres = mode.xres;
+        _colorMode.yres = mode.yres;
+        _colorMode.fps = mode.fps;
+        _colorMode.hfov = mode.hfov;
+
+        _handTracker = nt::HandTracker::create();
+        _handHandler = _handTracker->connectOnUpdate(std::bind(
+            &SensorDevice::_onHandUpdate, this, std::placeholders::_1));
+
+        _userTracker = nt::UserTracker::create();
+        _userHandler = _userTracker->connectOnUpdate(std::bind(
+            &SensorDevice::_onUserUpdate, this, std::placeholders::_1));
+        _newUserHandler = _userTracker->connectOnNewUser(std::bind(
+            &FrameSink::onNewUser, _sink, std::placeholders::_1));
+        _lostUserHandler = _userTracker->connectOnLostUser(std::bind(
+            &FrameSink::onLostUser, _sink, std::placeholders::_1));
+
+        _skeletonTracker = nt::SkeletonTracker::create();
+        _skeletonHandler = _skeletonTracker->connectOnUpdate(std::bind(
+            &SensorDevice::_onSkeletonUpdate, this, std::placeholders::_1));
+
+        _gestureRecognizer = nt::GestureRecognizer::create();
+        _gestureHandler = _gestureRecognizer->connectOnNewGestures(std::bind(
+            &SensorDevice::_onNewGesture, this, std::placeholders::_1));
+
+        _issuesHandler = nt::Nuitrack::connectOnIssuesUpdate(std::bind(
+            &SensorDevice::_onIssuesUpdate, this, std::placeholders::_1));
+        _initialized = true;
+
+        // Sensors added later join the running session.
+        if (!sessionRunning)
+        {
+            nt::Nuitrack::run();
+            sessionRunning = true;
+        }
+    }
+    catch (const nt::Exception &e)
+    {
+        _destroyModules();
+        leaveSession();
+        std::string msg("Nuitrack update failed: ");
+        msg += exceptionType_str[e.type()];
+        throw NuitrackException(msg);
+    }
+    catch (...)
+    {
+        _destroyModules();
+        leaveSession();
+        throw;
+    }
+}
+
+void SensorDevice::update()
+{
+    if (!_initialized)
+        throw NuitrackException("Device is not initialized.");
+
+    try
+    {
+        nt::Nuitrack::waitUpdate(_skeletonTracker);
+    }
+    catch (nt::LicenseNotAcquiredException &e)
+    {
+        throw NuitrackException("License not acquired.");
+    }
+    catch (const nt::Exception &e)
+    {
+        std::string msg("Nuitrack update failed: ");
+        msg += exceptionType_str[e.type()];
+        throw NuitrackException(msg);
+    }
+}
+
+bool SensorDevice::interrupt()
+{
+    // The SDK cannot cancel waitUpdate(), and releasing it from another
+    // thread would also stop the other sensors of the session.
+    return false;
+}
+
+void SensorDevice::_destroyModules()
+{
+    if (_initialized)
+    {
+        _depthSensor->disconnectOnNewFrame(_depthHandler);
+        _colorSensor->disconnectOnNewFrame(_colorHandler);
+        _handTracker->disconnectOnUpdate(_handHandler);
+        _userTracker->disconnectOnUpdate(_userHandler);
+        _userTracker->disconnectOnNewUser(_newUserHandler);
+        _userTracker->disconnectOnLostUser(_lostUserHandler);
+        _skeletonTracker->disconnectOnUpdate(_skeletonHandler);
+        _gestureRecognizer->disconnectOnNewGestures(_gestureHandler);
+        nt::Nuitrack::disconnectOnIssuesUpdate(_issuesHandler);
+        _initialized = false;
+    }
+
+    _depthSensor.reset();
+    _colorSensor.reset();
+    _handTracker.reset();
+    _userTracker.reset();
+    _skeletonTracker.reset();
+    _gestureRecognizer.reset();
+}
+
+void SensorDevice::release()
+{
+    if (!_initialized)
+        return;
+
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    _destroyModules();
+    leaveSession();
+}
+
+StreamMode SensorDevice::depthMode() const
+{
+    return _depthMode;
+}
+
+StreamMode SensorDevice::colorMode() const
+{
+    return _colorMode;
+}
+
+std::string SensorDevice::facesJson()
+{
+    return nt::Nuitrack::getInstancesJson();
+}
+
+std::string SensorDevice::name() const
+{
+    return _serial.empty() ? "default sensor" : "sensor " + _serial;
+}
+
+std::vector<DeviceInfo> SensorDevice::list(const std::string &configPath)
+{
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    enterSession(configPath);
+
+    std::vector<DeviceInfo> devices;
+    try
+    {
+        for (nt::device::NuitrackDevice::Ptr device :
+             nt::Nuitrack::getDeviceList())
+        {
+            DeviceInfo info;
+            info.serial = device->getInfo(
+                nt::device::DeviceInfoType::SERIAL_NUMBER);
+            info.name = device->getInfo(nt::device::DeviceInfoType::DEVICE_NAME);
+            devices.push_back(info);
+        }
+    }
+    catch (const nt::Exception &e)
+    {
+        leaveSession();
+        std::string msg("Could not list the sensors: ");
+        msg += exceptionType_str[e.type()];
+        throw NuitrackException(msg);
+    }
+
+    leaveSession();
+    return devices;
+}
+
+void SensorDevice::_onNewDepthFrame(nt::DepthFrame::Ptr frame)
+{
+    DepthImage image;
+    image.timestamp = frame->getTimestamp();
+    image.rows = frame->getRows();
+    image.cols = frame->getCols();
+    image.data = frame->getData();
+    _sink->onDepthFrame(image);
+}
+
+void SensorDevice::_onNewRGBFrame(nt::RGBFrame::Ptr frame)
+{
+    ColorImage image;
+    image.timestamp = frame->getTimestamp();
+    image.rows = frame->getRows();
+    image.cols = frame->getCols();
+    image.data = (const uint8_t *)frame->getData();
+    _sink->onColorFrame(image);
+}
+
+void SensorDevice::_onUserUpdate(nt::UserFrame::Ptr frame)
+{
+    DepthImage image;
+    image.timestamp = frame->getTimestamp();
+    image.rows = frame->getRows();
+    image.cols = frame->getCols();
+    image.data = frame->getData();
+    _sink->onUserFrame(image);
+}
+
+void SensorDevice::_onSkeletonUpdate(nt::SkeletonData::Ptr userSkeletons)
+{
+    _skeletons.timestamp = userSkeletons->getTimestamp();
+    _skeletons.skeletons.clear();
+    for (const nt::Skeleton &skel : userSkeletons->getSkeletons())
+    {
+        _skeletons.skeletons.push_back(SkeletonState());
+        SkeletonState &state = _skeletons.skeletons.back();
+        state.userId = skel.id;
+        for (int i = 0; i < SKELETON_JOINTS; i++)
+        {
+            const nt::Joint &joint = skel.joints[skeletonJoints[i]];
+            JointState &out = state.joints[i];
+            out.type = joint.type;
+            out.confidence = joint.confidence;
+            out.real[0] = joint.real.x;
+            out.real[1] = joint.real.y;
+            out.real[2] = joint.real.z;
+            out.proj[0] = joint.proj.x;
+            out.proj[1] = joint.proj.y;
+            out.proj[2] = joint.proj.z;
+            std::copy(joint.orient.matrix, joint.orient.matrix + 9, out.orient);
+        }
+    }
+    _sink->onSkeletons(_skeletons);
+}
+
+void SensorDevice::_onHandUpdate(nt::HandTrackerData::Ptr handData)
+{
+    if (!handData)
+        return;
+
+    _hands.timestamp = handData->getTimestamp();
+    _hands.users.clear();
+    for (const nt::UserHands &hands : handData->getUsersHands())
+    {
+        _hands.users.push_back(UserHandsState());
+        UserHandsState &state = _hands.users.back();
+        state.userId = hands.userId;
+        toHandState(hands.leftHand, state.left);
+        toHandState(hands.rightHand, state.right);
+    }
+    _sink->onHands(_hands);
+}
+
+void SensorDevice::_onNewGesture(nt::GestureData::Ptr gestureData)
+{
+    std::vector<GestureEvent> gestures;
+    for (const nt::Gesture &gest : gestureData->getGestures())
+    {
+        GestureEvent event;
+        event.userId = gest.userId;
+        event.type = gest.type;
+        gestures.push_back(event);
+    }
+    _sink->onGestures(gestures);
+}
+
+void SensorDevice::_onIssuesUpdate(nt::IssuesData::Ptr issuesData)
+{
+    if (!issuesData)
+        return;
+
+    std::vector<IssueEvent> issues;
+    for (int userId = 0; userId < 8; userId++)
+    {
+        auto issueFB = issuesData->getUserIssue<nt::FrameBorderIssue>(userId);
+        if (issueFB)
+        {
+            IssueEvent event;
+            event.userId = userId;
+            event.occlusion = false;
+            event.left = issueFB->isLeft();
+            event.right = issueFB->isRight();
+            event.top = issueFB->isTop();
+            issues.push_back(event);
+        }
+
+        auto issueOcc = issuesData->getUserIssue<nt::OcclusionIssue>(userId);
+        if (issueOcc)
+        {
+            IssueEvent event;
+            event.userId = userId;
+            event.occlusion = true;
+            event.left = event.right = event.top = false;
+            issues.push_back(event);
+        }
+    }
+
+    if (!issues.empty())
+        _sink->onIssues(issues);
+}
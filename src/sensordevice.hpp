@@ -0,0 +1,194 @@
+/**
+ * @file sensordevice.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the Device backed by a Nuitrack sensor.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef sensordevice_H
+#define sensordevice_H
+
+#include <nuitrack/Nuitrack.h>
+
+#include "device.hpp"
+
+/**
+ * @brief Device backed by a sensor, through the Nuitrack SDK.
+ *
+ * The SDK is initialized once per process and shared by all sensors: it is
+ * started with the first SensorDevice and released with the last one. Each
+ * SensorDevice selects its sensor before creating its own modules, so their
+ * callbacks only carry data of that sensor.
+ *
+ * As the session is shared, releasing and initializing a SensorDevice while
+ * other sensors are in use only recreates its modules: the SDK itself is
+ * not released, initialized and run again.
+ */
+class SensorDevice : public Device
+{
+private:
+    /// Serial number of the sensor. Empty for the default sensor.
+    std::string _serial;
+
+    /// Path to the Nuitrack configuration file.
+    std::string _configPath;
+
+    /// Receiver of the data.
+    FrameSink *_sink;
+
+    /// Whether the modules were created.
+    bool _initialized;
+
+    /// Output mode of the depth stream.
+    StreamMode _depthMode;
+
+    /// Output mode of the color stream.
+    StreamMode _colorMode;
+
+    /// Handler for the depth image interface.
+    tdv::nuitrack::DepthSensor::Ptr _depthSensor;
+
+    /// Handler for the color image interface.
+    tdv::nuitrack::ColorSensor::Ptr _colorSensor;
+
+    /// Handler for the user tracker interface.
+    tdv::nuitrack::UserTracker::Ptr _userTracker;
+
+    /// Handler for the skeleton tracker interface.
+    tdv::nuitrack::SkeletonTracker::Ptr _skeletonTracker;
+
+    /// Handler for the hand tracker interface.
+    tdv::nuitrack::HandTracker::Ptr _handTracker;
+
+    /// Handler for the gesture recognizer interface.
+    tdv::nuitrack::GestureRecognizer::Ptr _gestureRecognizer;
+
+    /// IDs of the connected callbacks, used to disconnect them.
+    uint64_t _depthHandler, _colorHandler, _userHandler, _newUserHandler,
+        _lostUserHandler, _skeletonHandler, _handHandler, _gestureHandler,
+        _issuesHandler;
+
+    /// Skeleton frame reused between updates.
+    SkeletonFrame _skeletons;
+
+    /// Hand frame reused between updates.
+    HandFrame _hands;
+
+    /**
+     * @brief Selects the sensor used by the modules created next.
+     */
+    void _selectSensor();
+
+    /**
+     * @brief Disconnects the callbacks and destroys the modules.
+     */
+    void _destroyModules();
+
+    /**
+     * @brief Callback method for the depth sensor.
+     * 
+     * @param frame 
+     */
+    void _onNewDepthFrame(tdv::nuitrack::DepthFrame::Ptr frame);
+
+    /**
+     * @brief Callback method for the color camera.
+     * 
+     * @param frame 
+     */
+    void _onNewRGBFrame(tdv::nuitrack::RGBFrame::Ptr frame);
+
+    /**
+     * @brief Callback method for the user tracker.
+     * 
+     * @param frame 
+     */
+    void _onUserUpdate(tdv::nuitrack::UserFrame::Ptr frame);
+
+    /**
+     * @brief Callback method for the skeleton tracker.
+     * 
+     * @param userSkeletons 
+     */
+    void _onSkeletonUpdate(tdv::nuitrack::SkeletonData::Ptr userSkeletons);
+
+    /**
+     * @brief Callback method for the hand tracker.
+     * 
+     * @param handData 
+     */
+    void _onHandUpdate(tdv::nuitrack::HandTrackerData::Ptr handData);
+
+    /**
+     * @brief Callback method for the gesture recognizer.
+     * 
+     * @param gestureData 
+     */
+    void _onNewGesture(tdv::nuitrack::GestureData::Ptr gestureData);
+
+    /**
+     * @brief Callback method for the issue tracker.
+     * 
+     * @param issuesData 
+     */
+    void _onIssuesUpdate(tdv::nuitrack::IssuesData::Ptr issuesData);
+
+public:
+    /**
+     * @brief Construct a new SensorDevice object.
+     * 
+     * @param serial Serial number of the sensor. Empty for the default sensor.
+     * @param configPath Path to the Nuitrack configuration file.
+     */
+    SensorDevice(const std::string &serial, const std::string &configPath);
+
+    /**
+     * @brief Destroy the SensorDevice object, releasing it if needed.
+     */
+    ~SensorDevice();
+
+    void init(FrameSink *sink);
+    void update();
+    bool interrupt();
+    void release();
+    StreamMode depthMode() const;
+    StreamMode colorMode() const;
+    std::string facesJson();
+    std::string name() const;
+
+    /**
+     * @brief Lists the sensors connected to the computer.
+     * 
+     * @param configPath Path to the Nuitrack configuration file, used if the
+     *      SDK is not initialized yet.
+     */
+    static std::vector<DeviceInfo> list(const std::string &configPath);
+};
+
+#endif
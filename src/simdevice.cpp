@@ -0,0 +1,353 @@
+/**
+ * @file simdevice.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains a Device that produces synthetic frames.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "simdevice.hpp"
+#include "exception.hpp"
+#include <nuitrack/Nuitrack.h>
+#include <algorithm>
+#include <thread>
+
+namespace nt = tdv::nuitrack;
+
+/// Resolution of the simulated streams.
+static const int SIM_COLS = 640, SIM_ROWS = 480;
+
+/// Horizontal field of view of the simulated camera (57 degrees).
+static const float SIM_HFOV = 0.9948f;
+
+/// Height of the camera above the floor, in millimeters.
+static const float SIM_HEIGHT = 1200;
+
+/// Distance from the camera to the back wall, in millimeters.
+static const float SIM_WALL = 5000;
+
+/// Radius and height of the cylinder representing a user, in millimeters.
+static const float SIM_USER_RADIUS = 220, SIM_USER_HEIGHT = 1700;
+
+/// Timestamps follow this rate when frames are produced as fast as possible.
+static const int SIM_DEFAULT_FPS = 30;
+
+/**
+ * @brief Joint of the standing pose, relative to the user's floor position.
+ */
+struct SimJoint
+{
+    nt::JointType type;
+    float offset[3];
+};
+
+/// Standing pose, in the order of the "Skeleton" tuple.
+static const SimJoint standingPose[SKELETON_JOINTS] =
+{
+    {nt::JOINT_HEAD, {0, 1600, 0}},
+    {nt::JOINT_NECK, {0, 1450, 0}},
+    {nt::JOINT_TORSO, {0, 1200, 0}},
+    {nt::JOINT_WAIST, {0, 1000, 0}},
+    {nt::JOINT_LEFT_COLLAR, {-80, 1430, 0}},
+    {nt::JOINT_LEFT_SHOULDER, {-200, 1420, 0}},
+    {nt::JOINT_LEFT_ELBOW, {-230, 1150, 0}},
+    {nt::JOINT_LEFT_WRIST, {-240, 900, 0}},
+    {nt::JOINT_LEFT_HAND, {-240, 830, 0}},
+    {nt::JOINT_RIGHT_COLLAR, {80, 1430, 0}},
+    {nt::JOINT_RIGHT_SHOULDER, {200, 1420, 0}},
+    {nt::JOINT_RIGHT_ELBOW, {230, 1150, 0}},
+    {nt::JOINT_RIGHT_WRIST, {240, 900, 0}},
+    {nt::JOINT_RIGHT_HAND, {240, 830, 0}},
+    {nt::JOINT_LEFT_HIP, {-100, 950, 0}},
+    {nt::JOINT_LEFT_KNEE, {-100, 520, 0}},
+    {nt::JOINT_LEFT_ANKLE, {-100, 80, 0}},
+    {nt::JOINT_RIGHT_HIP, {100, 950, 0}},
+    {nt::JOINT_RIGHT_KNEE, {100, 520, 0}},
+    {nt::JOINT_RIGHT_ANKLE, {100, 80, 0}}
+};
+
+/// Indices of the joints moved by the waving arm.
+static const int SIM_RIGHT_WRIST = 12, SIM_RIGHT_HAND = 13;
+
+/// Indices of the hand joints.
+static const int SIM_LEFT_HAND = 8;
+
+SimulatedDevice::SimulatedDevice(int fps, int users, int failAfter,
+                                 int stallAfter, int hangAfter)
+    : _fps(std::max(fps, 0)), _users(std::max(users, 0)),
+      _failAfter(std::max(failAfter, 0)), _stallAfter(std::max(stallAfter, 0)),
+      _hangAfter(std::max(hangAfter, 0)), _updates(0), _interrupted(false),
+      _sink(NULL), _frame(0)
+{
+    _mode.xres = SIM_COLS;
+    _mode.yres = SIM_ROWS;
+    _mode.fps = _fps ? _fps : SIM_DEFAULT_FPS;
+    _mode.hfov = SIM_HFOV;
+    _intrinsics = Intrinsics(SIM_COLS, SIM_ROWS, SIM_HFOV);
+}
+
+void SimulatedDevice::init(FrameSink *sink)
+{
+    if (_sink)
+        throw NuitrackException("Device is already initialized.");
+
+    // The empty room: floor below the horizon, back wall everywhere else.
+    _background.resize((size_t)SIM_ROWS * SIM_COLS);
+    for (int r = 0; r < SIM_ROWS; r++)
+    {
+        float ray = (_intrinsics.cy - (r + 0.5f)) / _intrinsics.fy;
+        float depth = ray < 0 ? std::min(SIM_HEIGHT / -ray, SIM_WALL) : SIM_WALL;
+        std::fill(_background.begin() + (size_t)r * SIM_COLS,
+                  _background.begin() + (size_t)(r + 1) * SIM_COLS,
+                  (uint16_t)depth);
+    }
+
+    _depth.resize(_background.size());
+    _labels.resize(_background.size());
+    _color.resize(_background.size() * 3);
+    _frame = 0;
+    _updates = 0;
+    {
+        std::lock_guard<std::mutex> lock(_hangMutex);
+        _interrupted = false;
+    }
+    _due = std::chrono::steady_clock::now();
+    _sink = sink;
+}
+
+void SimulatedDevice::_position(int user, double seconds, float &x,
+                                float &z) const
+{
+    // Each user walks along its own ellipse, at its own pace.
+    double phase = 2 * M_PI * user / std::max(_users, 1);
+    double angle = phase + seconds * (0.3 + 0.1 * user);
+    x = (float)(1200 * std::sin(angle));
+    z = (float)(2800 + 800 * std::cos(angle));
+}
+
+void SimulatedDevice::_project(const float *real, float *proj) const
+{
+    proj[0] = (_intrinsics.cx + real[0] * _intrinsics.fx / real[2]) / SIM_COLS;
+    proj[1] = (_intrinsics.cy - real[1] * _intrinsics.fy / real[2]) / SIM_ROWS;
+    proj[2] = real[2];
+}
+
+void SimulatedDevice::_renderUser(int label, float x, float z)
+{
+    const Intrinsics &k = _intrinsics;
+    int c0 = std::max(0, (int)(k.cx + (x - SIM_USER_RADIUS) * k.fx / z));
+    int c1 = std::min(SIM_COLS, (int)(k.cx + (x + SIM_USER_RADIUS) * k.fx / z) + 1);
+    int r0 = std::max(0, (int)(k.cy - (SIM_USER_HEIGHT - SIM_HEIGHT) * k.fy / z));
+    int r1 = std::min(SIM_ROWS, (int)(k.cy + SIM_HEIGHT * k.fy / z) + 1);
+
+    for (int c = c0; c < c1; c++)
+    {
+        // Front surface of the cylinder seen by this column.
+        float u = (c + 0.5f - k.cx) * z / k.fx - x;
+        float h = SIM_USER_RADIUS * SIM_USER_RADIUS - u * u;
+        if (h <= 0)
+            continue;
+        uint16_t depth = (uint16_t)(z - std::sqrt(h));
+
+        for (int r = r0; r < r1; r++)
+        {
+            size_t i = (size_t)r * SIM_COLS + c;
+            if (depth < _depth[i])
+            {
+                _depth[i] = depth;
+                _labels[i] = (uint16_t)label;
+            }
+        }
+    }
+}
+
+void SimulatedDevice::_poseUser(int label, float x, float z, double seconds)
+{
+    _skeletons.skeletons.push_back(SkeletonState());
+    SkeletonState &skel = _skeletons.skeletons.back();
+    skel.userId = label;
+
+    // The right arm goes up and down, so trajectories are not static.
+    float wave = (float)(300 * (0.5 + 0.5 * std::sin(M_PI * seconds)));
+    for (int i = 0; i < SKELETON_JOINTS; i++)
+    {
+        JointState &joint = skel.joints[i];
+        joint.type = standingPose[i].type;
+        joint.confidence = 0.75f;
+        joint.real[0] = x + standingPose[i].offset[0];
+        joint.real[1] = standingPose[i].offset[1] - SIM_HEIGHT;
+        joint.real[2] = z + standingPose[i].offset[2];
+        if (i == SIM_RIGHT_WRIST || i == SIM_RIGHT_HAND)
+            joint.real[1] += wave;
+        _project(joint.real, joint.proj);
+        for (int j = 0; j < 9; j++)
+            joint.orient[j] = j % 4 == 0 ? 1.0f : 0.0f;
+    }
+
+    _hands.users.push_back(UserHandsState());
+    UserHandsState &hands = _hands.users.back();
+    hands.userId = label;
+    HandState *states[] = {&hands.left, &hands.right};
+    const int joints[] = {SIM_LEFT_HAND, SIM_RIGHT_HAND};
+    for (int i = 0; i < 2; i++)
+    {
+        const JointState &joint = skel.joints[joints[i]];
+        states[i]->tracked = true;
+        states[i]->proj[0] = joint.proj[0];
+        states[i]->proj[1] = joint.proj[1];
+        states[i]->click = false;
+        states[i]->pressure = 0;
+        std::copy(joint.real, joint.real + 3, states[i]->real);
+    }
+}
+
+void SimulatedDevice::update()
+{
+    if (!_sink)
+        throw NuitrackException("Device is not initialized.");
+
+    _updates++;
+    if (_failAfter && _updates > _failAfter)
+        throw NuitrackException("Nuitrack update failed: simulated fault");
+    if (_hangAfter && _updates > _hangAfter)
+    {
+        // Like a driver that never returns, until the caller gives up.
+        std::unique_lock<std::mutex> lock(_hangMutex);
+        _hangCv.wait(lock, [this] { return _interrupted; });
+        throw NuitrackException("Nuitrack update failed: interrupted");
+    }
+    if (_stallAfter && _updates > _stallAfter)
+    {
+        // Like a frozen sensor: no data, at the pace of the stream.
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(1000000 / _mode.fps));
+        return;
+    }
+
+    if (_fps)
+    {
+        std::this_thread::sleep_until(_due);
+        _due += std::chrono::microseconds(1000000 / _fps);
+        // Do not try to catch up after a stall, like a real sensor.
+        std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        if (_due < now)
+            _due = now;
+    }
+
+    int fps = _fps ? _fps : SIM_DEFAULT_FPS;
+    uint64_t timestamp = _frame * 1000000 / fps;
+    double seconds = (double)_frame / fps;
+
+    std::copy(_background.begin(), _background.end(), _depth.begin());
+    std::fill(_labels.begin(), _labels.end(), 0);
+    _skeletons.timestamp = timestamp;
+    _skeletons.skeletons.clear();
+    _hands.timestamp = timestamp;
+    _hands.users.clear();
+    for (int user = 0; user < _users; user++)
+    {
+        float x, z;
+        _position(user, seconds, x, z);
+        _renderUser(user + 1, x, z);
+        _poseUser(user + 1, x, z, seconds);
+    }
+
+    // Gray shading by depth, tinted by user.
+    static const uint8_t tint[4][3] =
+        {{255, 255, 255}, {255, 128, 128}, {128, 255, 128}, {128, 128, 255}};
+    for (size_t i = 0; i < _depth.size(); i++)
+    {
+        int gray = 255 - std::min(_depth[i] / 20, 255);
+        const uint8_t *t = tint[_labels[i] ? 1 + _labels[i] % 3 : 0];
+        for (int k = 0; k < 3; k++)
+            _color[i * 3 + k] = (uint8_t)(gray * t[k] / 255);
+    }
+
+    if (_frame == 0)
+        for (int user = 0; user < _users; user++)
+            _sink->onNewUser(user + 1);
+
+    DepthImage depth;
+    depth.timestamp = timestamp;
+    depth.rows = SIM_ROWS;
+    depth.cols = SIM_COLS;
+    depth.data = _depth.data();
+    _sink->onDepthFrame(depth);
+
+    ColorImage color;
+    color.timestamp = timestamp;
+    color.rows = SIM_ROWS;
+    color.cols = SIM_COLS;
+    color.data = _color.data();
+    _sink->onColorFrame(color);
+
+    DepthImage labels = depth;
+    labels.data = _labels.data();
+    _sink->onUserFrame(labels);
+
+    _sink->onSkeletons(_skeletons);
+    _sink->onHands(_hands);
+    _frame++;
+}
+
+bool SimulatedDevice::interrupt()
+{
+    {
+        std::lock_guard<std::mutex> lock(_hangMutex);
+        _interrupted = true;
+    }
+    _hangCv.notify_all();
+    return true;
+}
+
+void SimulatedDevice::release()
+{
+    _sink = NULL;
+}
+
+StreamMode SimulatedDevice::depthMode() const
+{
+    return _mode;
+}
+
+StreamMode SimulatedDevice::colorMode() const
+{
+    return _mode;
+}
+
+std::string SimulatedDevice::facesJson()
+{
+    return "{\"Instances\": []}";
+}
+
+std::string SimulatedDevice::name() const
+{
+    return "simulated device (" + std::to_string(_fps) + " fps, " +
+           std::to_string(_users) + " users)";
+}
@@ -0,0 +1,173 @@
+/**
+ * @file simdevice.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains a Device that produces synthetic frames.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef simdevice_H
+#define simdevice_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "device.hpp"
+#include "geometry.hpp"
+
+/**
+ * @brief Device that renders a synthetic room, with no sensor nor SDK.
+ *
+ * The room has a floor 1.2 m below the camera, a back wall 5 m away and a
+ * number of users walking along ellipses. Each update produces the depth,
+ * color and label images, the skeletons and the hands of the users, at a
+ * fixed frame rate, which makes it suitable for testing the scheduling of
+ * several devices.
+ *
+ * Faults can be injected to test the recovery of the caller: after a given
+ * number of updates the device fails (every update throws), stalls (updates
+ * return without data) or hangs (the update blocks until interrupt() is
+ * called), until it is released and initialized again.
+ */
+class SimulatedDevice : public Device
+{
+private:
+    /// Frame rate. Zero produces frames as fast as possible.
+    int _fps;
+
+    /// Number of simulated users.
+    int _users;
+
+    /// Number of updates after which the device fails. Zero never fails.
+    int _failAfter;
+
+    /// Number of updates after which the device stalls. Zero never stalls.
+    int _stallAfter;
+
+    /// Number of updates after which the device hangs. Zero never hangs.
+    int _hangAfter;
+
+    /// Number of updates since the device was initialized.
+    int _updates;
+
+    /// Protects _interrupted, which is set by other threads.
+    std::mutex _hangMutex;
+
+    /// Wakes a hung update.
+    std::condition_variable _hangCv;
+
+    /// Whether interrupt() was called since the device was initialized.
+    bool _interrupted;
+
+    /// Receiver of the data.
+    FrameSink *_sink;
+
+    /// Number of frames produced so far.
+    uint64_t _frame;
+
+    /// Time at which the next frame is due.
+    std::chrono::steady_clock::time_point _due;
+
+    /// Output mode shared by the depth and color streams.
+    StreamMode _mode;
+
+    /// Intrinsics used to render the scene.
+    Intrinsics _intrinsics;
+
+    /// Depth of the empty room, rendered once.
+    std::vector<uint16_t> _background;
+
+    /// Depth image of the current frame.
+    std::vector<uint16_t> _depth;
+
+    /// Label image of the current frame.
+    std::vector<uint16_t> _labels;
+
+    /// Color image of the current frame.
+    std::vector<uint8_t> _color;
+
+    /// Skeletons of the current frame.
+    SkeletonFrame _skeletons;
+
+    /// Hands of the current frame.
+    HandFrame _hands;
+
+    /**
+     * @brief Computes the floor position of a user at a given time.
+     *
+     * @param user Index of the user.
+     * @param seconds Time since the first frame.
+     * @param[out] x Position along x, in millimeters.
+     * @param[out] z Position along z, in millimeters.
+     */
+    void _position(int user, double seconds, float &x, float &z) const;
+
+    /**
+     * @brief Renders a user as a vertical cylinder in the depth and label
+     *      images.
+     */
+    void _renderUser(int label, float x, float z);
+
+    /**
+     * @brief Fills the skeleton and hands of a user standing at (x, z).
+     */
+    void _poseUser(int label, float x, float z, double seconds);
+
+    /**
+     * @brief Projects a real point to normalized projective coordinates.
+     */
+    void _project(const float *real, float *proj) const;
+
+public:
+    /**
+     * @brief Construct a new SimulatedDevice object.
+     *
+     * @param fps Frame rate. Zero produces frames as fast as possible.
+     * @param users Number of simulated users.
+     * @param failAfter Number of updates after which every update throws,
+     *      until the device is initialized again. Zero never fails.
+     * @param stallAfter Number of updates after which updates return without
+     *      data, until the device is initialized again. Zero never stalls.
+     * @param hangAfter Number of updates after which an update blocks until
+     *      interrupt() is called, and throws. Zero never hangs.
+     */
+    SimulatedDevice(int fps, int users, int failAfter = 0,
+                    int stallAfter = 0, int hangAfter = 0);
+
+    void init(FrameSink *sink);
+    void update();
+    bool interrupt();
+    void release();
+    StreamMode depthMode() const;
+    StreamMode colorMode() const;
+    std::string facesJson();
+    std::string name() const;
+};
+
+#endif
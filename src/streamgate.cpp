@@ -0,0 +1,105 @@
+/**
+ * @file streamgate.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the StreamGate class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "streamgate.hpp"
+
+StreamGate::StreamGate()
+{
+    configure(0, 1, false);
+}
+
+void StreamGate::configure(double rate, int every, bool requireUsers)
+{
+    _rate = rate > 0 ? rate : 0;
+    _every = every > 1 ? every : 1;
+    _requireUsers = requireUsers;
+    _phase = 0;
+    _next = 0;
+    _delivered = 0;
+    _skipped = 0;
+}
+
+bool StreamGate::accept(uint64_t timestamp, bool usersPresent)
+{
+    bool pass = !_requireUsers || usersPresent;
+
+    if (pass && _every > 1)
+    {
+        pass = _phase == 0;
+        _phase = (_phase + 1) % _every;
+    }
+
+    if (pass && _rate > 0)
+    {
+        uint64_t period = (uint64_t)(1e6 / _rate);
+
+        // Timestamps going backwards (e.g. the device was re-initialized)
+        // restart the grid from this frame instead of blocking the stream
+        // until they catch up.
+        if (timestamp + period < _next)
+            _next = timestamp;
+
+        pass = timestamp >= _next;
+        if (pass)
+        {
+            // Deliveries are scheduled on a fixed grid, so the average rate
+            // matches the target even when frames jitter. After a long gap
+            // the grid restarts from this frame.
+            _next += period;
+            if (_next <= timestamp || _next > timestamp + 2 * period)
+                _next = timestamp + period;
+        }
+    }
+
+    if (pass)
+        _delivered++;
+    else
+        _skipped++;
+    return pass;
+}
+
+void StreamGate::restart()
+{
+    _phase = 0;
+    _next = 0;
+}
+
+uint64_t StreamGate::delivered() const
+{
+    return _delivered;
+}
+
+uint64_t StreamGate::skipped() const
+{
+    return _skipped;
+}
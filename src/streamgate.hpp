@@ -0,0 +1,127 @@
+/**
+ * @file streamgate.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the StreamGate class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef streamgate_H
+#define streamgate_H
+
+#include <cstdint>
+
+/**
+ * @brief Streams delivered to the callbacks that can be rate limited.
+ */
+enum Stream
+{
+    STREAM_DEPTH,
+    STREAM_COLOR,
+    STREAM_USER,
+    STREAM_SKELETON,
+    STREAM_FACE,
+    STREAM_HANDS,
+    STREAM_COUNT
+};
+
+/**
+ * @brief Decides which frames of a stream are delivered.
+ *
+ * Frames can be decimated (every N-th frame), limited to a maximum rate
+ * (based on the frame timestamps) and/or dropped while nobody is tracked.
+ * The decision is made before any conversion, so skipped frames cost
+ * nothing besides the counter.
+ */
+class StreamGate
+{
+private:
+    /// Maximum delivery rate, in Hz. Zero means unlimited.
+    double _rate;
+
+    /// Deliver only one of every `_every` frames.
+    int _every;
+
+    /// Whether frames are dropped while no user is tracked.
+    bool _requireUsers;
+
+    /// Frames seen since the last decimated delivery.
+    int _phase;
+
+    /// Earliest timestamp (us) of the next delivery.
+    uint64_t _next;
+
+    /// Number of delivered frames.
+    uint64_t _delivered;
+
+    /// Number of skipped frames.
+    uint64_t _skipped;
+
+public:
+    /**
+     * @brief Construct a new StreamGate object that delivers every frame.
+     */
+    StreamGate();
+
+    /**
+     * @brief Sets the gate configuration and resets its counters.
+     *
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param requireUsers Whether to drop frames while no user is tracked.
+     */
+    void configure(double rate, int every, bool requireUsers);
+
+    /**
+     * @brief Decides whether a frame is delivered, and counts it.
+     *
+     * @param timestamp Frame timestamp, in microseconds.
+     * @param usersPresent Whether any user is currently tracked.
+     * @return true if the frame must be delivered.
+     */
+    bool accept(uint64_t timestamp, bool usersPresent);
+
+    /**
+     * @brief Restarts the schedule from the next frame, keeping the
+     *      configuration and the counters (e.g. when the device restarts its
+     *      timestamps).
+     */
+    void restart();
+
+    /**
+     * @brief Returns the number of delivered frames.
+     */
+    uint64_t delivered() const;
+
+    /**
+     * @brief Returns the number of skipped frames.
+     */
+    uint64_t skipped() const;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * @file threadpool.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the ThreadPool class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "threadpool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads)
+    : _body(NULL), _count(0), _chunk(1), _next(0), _active(0),
+      _generation(0), _stop(false)
+{
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 1; i < threads; i++)
+        _workers.push_back(std::thread(&ThreadPool::_workerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _jobCv.notify_all();
+
+    for (std::thread &worker : _workers)
+        worker.join();
+}
+
+size_t ThreadPool::size() const
+{
+    return _workers.size() + 1;
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool *pool = new ThreadPool();
+    return *pool;
+}
+
+void ThreadPool::_work()
+{
+    while (true)
+    {
+        size_t begin = _next.fetch_add(_chunk);
+        if (begin >= _count)
+            break;
+        (*_body)(begin, std::min(begin + _chunk, _count));
+    }
+}
+
+void ThreadPool::_workerLoop()
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobCv.wait(lock, [&] { return _stop || _generation != seen; });
+            if (_stop)
+                return;
+            seen = _generation;
+        }
+
+        _work();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_active == 0)
+            _doneCv.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t, size_t)> &body,
+                             size_t grain)
+{
+    if (!count)
+        return;
+
+    grain = std::max<size_t>(grain, 1);
+    if (_workers.empty() || count <= grain)
+    {
+        body(0, count);
+        return;
+    }
+
+    std::unique_lock<std::mutex> call(_callMutex, std::try_to_lock);
+    if (!call.owns_lock())
+    {
+        body(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _body = &body;
+        _count = count;
+        // A few chunks per thread keeps the load balanced without contention.
+        _chunk = std::max(grain, count / (size() * 4));
+        _next = 0;
+        _active = _workers.size();
+        _generation++;
+    }
+    _jobCv.notify_all();
+
+    _work();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCv.wait(lock, [&] { return _active == 0; });
+    _body = NULL;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file threadpool.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the ThreadPool class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef threadpool_H
+#define threadpool_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Minimal fork-join pool used to spread per-frame work across cores.
+ *
+ * Work is submitted as a range that is split in chunks and consumed by the
+ * workers and by the calling thread. parallelFor() only returns after the
+ * whole range is processed, so the body may safely reference stack data.
+ *
+ * One pool is shared by the whole process (see shared()), so several
+ * trackers do not start one thread per core each. A job posted while the
+ * pool is busy runs on the calling thread alone.
+ */
+class ThreadPool
+{
+private:
+    /// Worker threads. The calling thread also takes part in every job.
+    std::vector<std::thread> _workers;
+
+    /// Held by the thread whose job is running on the workers.
+    std::mutex _callMutex;
+
+    /// Protects the job description below.
+    std::mutex _mutex;
+
+    /// Signals the workers that a new job is available.
+    std::condition_variable _jobCv;
+
+    /// Signals the caller that all workers are done with the job.
+    std::condition_variable _doneCv;
+
+    /// Body of the current job.
+    const std::function<void(size_t, size_t)> *_body;
+
+    /// Size of the range of the current job.
+    size_t _count;
+
+    /// Number of elements handed out at a time.
+    size_t _chunk;
+
+    /// Next element of the range to be handed out.
+    std::atomic<size_t> _next;
+
+    /// Number of workers still running the current job.
+    size_t _active;
+
+    /// Incremented every time a new job is posted.
+    uint64_t _generation;
+
+    /// Tells the workers to exit.
+    bool _stop;
+
+    /**
+     * @brief Main loop of each worker thread.
+     */
+    void _workerLoop();
+
+    /**
+     * @brief Consumes chunks of the current job until it is exhausted.
+     */
+    void _work();
+
+public:
+    /**
+     * @brief Construct a new ThreadPool object.
+     *
+     * @param threads Total number of threads, including the caller. Zero uses
+     *      the number of hardware threads.
+     */
+    ThreadPool(size_t threads = 0);
+
+    /**
+     * @brief Stops and joins all worker threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Returns the number of threads taking part in each job.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the pool shared by the whole process, sized to the
+     *      number of hardware threads. It is never destroyed, so it outlives
+     *      the objects using it during exit.
+     */
+    static ThreadPool &shared();
+
+    /**
+     * @brief Runs `body(begin, end)` over sub-ranges covering [0, count).
+     *
+     * If another thread is running a job, the whole range is processed by
+     * the calling thread, as the cores are already busy.
+     *
+     * @param count Size of the range.
+     * @param body Function processing a sub-range. It must not throw.
+     * @param grain Minimum number of elements per chunk.
+     */
+    void parallelFor(size_t count,
+                     const std::function<void(size_t, size_t)> &body,
+                     size_t grain = 1);
+};
+
+#endif
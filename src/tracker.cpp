@@ -0,0 +1,1033 @@
+/**
+ * @file tracker.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the Tracker class, the native core of pynuitrack.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "tracker.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/// Tracker whose worker is the current thread, if any.
+static thread_local const Tracker *currentWorker = NULL;
+
+Tracker::Tracker()
+    : _running(false), _pool(&ThreadPool::shared()), _gestures(_pool),
+      _depthFilter(_pool), _offlineFilter(_pool), _voxels(_pool)
+{
+    _depthRows = 0;
+    _depthCols = 0;
+    _worldFrame = false;
+    _floorFound = false;
+    _labelTimestamp = 0;
+    _depthTimestamp = 0;
+    _voxelsPending = false;
+    _occupancyFromMask = false;
+    _skeletonCount = 0;
+    _watchdogTimeout = 0;
+    _watchdogAttempts = 5;
+    _updating = false;
+    _idleTime = 0;
+    _hung = false;
+    _monitorStop = false;
+}
+
+Tracker::~Tracker()
+{
+    _stopWorker();
+    _stopMonitor();
+    if (_device)
+        _device->release();
+}
+
+void Tracker::init(const std::string &configPath, const std::string &device)
+{
+    if (_device)
+        throw NuitrackException("Nuitrack is already initialized.");
+
+    std::unique_ptr<Device> newDevice = createDevice(device, configPath);
+    newDevice->init(this);
+
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _depthMode = newDevice->depthMode();
+    _colorMode = newDevice->colorMode();
+    _device = std::move(newDevice);
+    _lastData = std::chrono::steady_clock::now();
+    _idleTime = 0;
+}
+
+void Tracker::update()
+{
+    if (!_device)
+        throw NuitrackException("Nuitrack is not initialized.");
+    if (_worker.joinable())
+        throw NuitrackException("Nuitrack is updated by its own thread.");
+
+    _updateDevice();
+}
+
+void Tracker::_updateDevice()
+{
+    double timeout;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        timeout = _watchdogTimeout;
+        if (timeout > 0)
+        {
+            if (!_monitor.joinable())
+            {
+                _monitorStop = false;
+                _monitor = std::thread(&Tracker::_monitorLoop, this);
+            }
+            _updateStart = std::chrono::steady_clock::now();
+            _updating = true;
+        }
+    }
+    if (timeout <= 0)
+    {
+        _device->update();
+        return;
+    }
+
+    std::string error;
+    try
+    {
+        _device->update();
+    }
+    catch (const NuitrackException &e)
+    {
+        error = e.what();
+    }
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        _updating = false;
+        // Updates without data add up, so a device that keeps returning
+        // empty-handed is detected, but not a caller pausing between them.
+        if (_lastData >= _updateStart)
+            _idleTime = std::chrono::duration<double>(now - _lastData).count();
+        else
+            _idleTime +=
+                std::chrono::duration<double>(now - _updateStart).count();
+
+        if (_hung)
+        {
+            // Already counted by the monitor.
+            _hung = false;
+            error = "Nuitrack hung: update blocked for " +
+                    std::to_string(std::chrono::duration<double>(
+                        now - std::max(_updateStart, _lastData)).count()) +
+                    " s";
+        }
+        else if (!error.empty())
+            _watchdogStats.failures++;
+        else if (_idleTime > timeout)
+        {
+            _watchdogStats.stalls++;
+            error = "Nuitrack stalled: no data for " +
+                    std::to_string(_idleTime) + " s";
+        }
+        else
+            return;
+    }
+
+    _recover(error);
+}
+
+void Tracker::_recover(const std::string &reason)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    int attempts;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _watchdogStats.lastError = reason;
+        attempts = std::max(_watchdogAttempts, 1);
+
+        // Users are tracked again from scratch, as after a real loss. Their
+        // buffers are dropped too, as the device restarts its timestamps.
+        std::set<int> lost;
+        lost.swap(_trackedUsers);
+        for (int userId : lost)
+            onLostUser(userId);
+        _skeletonCount = 0;
+    }
+
+    // The lock is not held while the device starts, so the getters keep
+    // working during the recovery.
+    for (int attempt = 1; ; attempt++)
+    {
+        try
+        {
+            _device->release();
+            _device->init(this);
+            break;
+        }
+        catch (const NuitrackException &)
+        {
+            if (attempt >= attempts)
+            {
+                std::lock_guard<std::recursive_mutex> lock(_mutex);
+                _watchdogStats.failedRecoveries++;
+                throw;
+            }
+        }
+
+        // Gives a reconnected sensor some time to settle.
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 * attempt));
+    }
+
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _depthMode = _device->depthMode();
+    _colorMode = _device->colorMode();
+    _lastData = end;
+    _idleTime = 0;
+    // The device restarts its timestamps.
+    for (StreamGate &gate : _gates)
+        gate.restart();
+    _labelBuffer.clear();
+    _watchdogStats.recoveries++;
+    _watchdogStats.lastRecoveryMs = ms;
+    _watchdogStats.maxRecoveryMs = std::max(_watchdogStats.maxRecoveryMs, ms);
+    _watchdogStats.totalRecoveryMs += ms;
+}
+
+void Tracker::_monitorLoop()
+{
+    std::unique_lock<std::recursive_mutex> lock(_mutex);
+    while (!_monitorStop)
+    {
+        if (_watchdogTimeout <= 0)
+        {
+            _monitorCv.wait(lock);
+            continue;
+        }
+
+        // Checks a few times per timeout, so hangs are flagged soon after it
+        // expires.
+        _monitorCv.wait_for(
+            lock, std::chrono::duration<double>(_watchdogTimeout / 4));
+        // Only this update counts: stalls spanning several updates are
+        // detected once each of them returns.
+        std::chrono::duration<double> idle =
+            std::chrono::steady_clock::now() -
+            std::max(_updateStart, _lastData);
+        if (_monitorStop || !_updating || _hung ||
+            _watchdogTimeout <= 0 || idle.count() <= _watchdogTimeout)
+            continue;
+
+        // The updating thread recovers the device once it is woken.
+        _hung = true;
+        _watchdogStats.hangs++;
+        _device->interrupt();
+    }
+}
+
+void Tracker::_stopMonitor()
+{
+    if (!_monitor.joinable())
+        return;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _monitorStop = true;
+    }
+    _monitorCv.notify_all();
+    _monitor.join();
+}
+
+void Tracker::_workerLoop()
+{
+    currentWorker = this;
+    if (_workerStart)
+        _workerStart();
+
+    while (_running)
+    {
+        try
+        {
+            _updateDevice();
+        }
+        catch (const std::exception &e)
+        {
+            _workerError = e.what();
+            _running = false;
+        }
+        catch (...)
+        {
+            _workerError = "Nuitrack stopped by an unknown error.";
+            _running = false;
+        }
+    }
+
+    if (_workerStop)
+        _workerStop();
+    currentWorker = NULL;
+}
+
+std::string Tracker::_stopWorker()
+{
+    if (!_worker.joinable())
+        return "";
+    if (_worker.get_id() == std::this_thread::get_id())
+        throw NuitrackException("Cannot stop Nuitrack from its own callbacks.");
+
+    _running = false;
+    _worker.join();
+
+    std::string error;
+    error.swap(_workerError);
+    return error;
+}
+
+void Tracker::start()
+{
+    if (!_device)
+        throw NuitrackException("Nuitrack is not initialized.");
+    if (_running)
+        throw NuitrackException("Nuitrack is already running.");
+
+    // Joins a worker stopped by an error, raising that error.
+    stop();
+
+    _running = true;
+    _worker = std::thread(&Tracker::_workerLoop, this);
+}
+
+void Tracker::stop()
+{
+    std::string error = _stopWorker();
+    if (!error.empty())
+        throw NuitrackException(error);
+}
+
+bool Tracker::isRunning() const
+{
+    return _running;
+}
+
+bool Tracker::inWorkerThread() const
+{
+    return currentWorker == this;
+}
+
+void Tracker::setWorkerHooks(std::function<void()> onStart,
+                             std::function<void()> onStop)
+{
+    if (_worker.joinable())
+        throw NuitrackException("Nuitrack is updated by its own thread.");
+
+    _workerStart = onStart;
+    _workerStop = onStop;
+}
+
+void Tracker::release()
+{
+    std::string error = _stopWorker();
+    _stopMonitor();
+
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _floor.stop();
+    _trackedUsers.clear();
+    _skeletonCount = 0;
+    _history.clear();
+    _labelBuffer.clear();
+    _voxelsPending = false;
+    if (_device)
+        _device->release();
+    _device.reset();
+
+    if (!error.empty())
+        throw NuitrackException(error);
+}
+
+std::string Tracker::deviceName()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _device ? _device->name() : "";
+}
+
+StreamMode Tracker::depthMode()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _depthMode;
+}
+
+StreamMode Tracker::colorMode()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _colorMode;
+}
+
+void Tracker::setDepthCallback(DepthCallback callback, double rate, int every,
+                               bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _depthCallback = callback;
+    _compressedDepthCallback = nullptr;
+    _gates[STREAM_DEPTH].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setCompressedDepthCallback(CompressedCallback callback,
+                                         double rate, int every,
+                                         bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _depthCallback = nullptr;
+    _compressedDepthCallback = callback;
+    _gates[STREAM_DEPTH].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setColorCallback(ColorCallback callback, double rate, int every,
+                               bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _colorCallback = callback;
+    _gates[STREAM_COLOR].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setUserCallback(DepthCallback callback, double rate, int every,
+                              bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _userCallback = callback;
+    _compressedUserCallback = nullptr;
+    _gates[STREAM_USER].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setCompressedUserCallback(CompressedCallback callback,
+                                        double rate, int every,
+                                        bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _userCallback = nullptr;
+    _compressedUserCallback = callback;
+    _gates[STREAM_USER].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setSkeletonCallback(SkeletonCallback callback, double rate,
+                                  int every, bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _skeletonCallback = callback;
+    _gates[STREAM_SKELETON].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setFaceCallback(FaceCallback callback, double rate, int every,
+                              bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _faceCallback = callback;
+    _gates[STREAM_FACE].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setHandsCallback(HandsCallback callback, double rate, int every,
+                               bool onlyWithUsers)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _handsCallback = callback;
+    _gates[STREAM_HANDS].configure(rate, every, onlyWithUsers);
+}
+
+void Tracker::setGestureCallback(GestureCallback callback)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _gestureCallback = callback;
+}
+
+void Tracker::setTemplateGestureCallback(TemplateGestureCallback callback)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _templateGestureCallback = callback;
+}
+
+void Tracker::setIssueCallback(IssueCallback callback)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _issueCallback = callback;
+}
+
+void Tracker::onIssues(const std::vector<IssueEvent> &issues)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (_issueCallback && !issues.empty())
+        _issueCallback(issues);
+}
+
+void Tracker::onGestures(const std::vector<GestureEvent> &gestures)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (_gestureCallback)
+        _gestureCallback(gestures);
+}
+
+void Tracker::onUserFrame(const DepthImage &frame)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (_occupancy.enabled() && _occupancyFromMask)
+        _addMaskCentroids(frame);
+
+    if (_voxels.enabled())
+    {
+        _labelBuffer.assign(frame.data,
+                            frame.data + (size_t)frame.rows * frame.cols);
+        _labelTimestamp = frame.timestamp;
+        if (_voxelsPending && _depthTimestamp == frame.timestamp)
+            _integrateVoxels(true);
+    }
+
+    if ((_userCallback || _compressedUserCallback) &&
+        _gates[STREAM_USER].accept(frame.timestamp, _usersPresent()))
+    {
+        if (_compressedUserCallback)
+        {
+            _codec.compressLabels(frame.data, frame.rows, frame.cols,
+                                  _compressed);
+            CompressedImage image = {frame.timestamp, _compressed.data(),
+                                     _compressed.size()};
+            _compressedUserCallback(image);
+        }
+        else
+            _userCallback(frame);
+    }
+}
+
+void Tracker::_integrateVoxels(bool labeled)
+{
+    _voxelsPending = false;
+    const uint16_t *labels =
+        labeled && _labelBuffer.size() == _depthBuffer.size() ?
+        _labelBuffer.data() : NULL;
+    _voxels.integrate(_depthBuffer.data(), labels, _depthRows, _depthCols,
+                      _depthIntrinsics, _world);
+}
+
+void Tracker::_addMaskCentroids(const DepthImage &frame)
+{
+    // Every other pixel is enough to locate the centroid.
+    const int stride = 2;
+    const uint16_t *labels = frame.data;
+    int nCols = frame.cols;
+    int nRows = frame.rows;
+    if (nCols != _depthCols || nRows != _depthRows || !_depthIntrinsics.valid())
+        return;
+
+    // Sums of x, z and the pixel count, indexed by the user label.
+    std::vector<double> sums;
+    for (int r = 0; r < nRows; r += stride)
+    {
+        const uint16_t *labelRow = labels + (size_t)r * nCols;
+        const uint16_t *depthRow = &_depthBuffer[(size_t)r * nCols];
+        for (int c = 0; c < nCols; c += stride)
+        {
+            uint16_t label = labelRow[c];
+            if (!label || !depthRow[c])
+                continue;
+
+            if (sums.size() < (label + 1u) * 3)
+                sums.resize((label + 1u) * 3, 0.0);
+
+            float p[3];
+            _depthIntrinsics.backproject((float)c, (float)r, depthRow[c], p);
+            _world.apply(p, p);
+            sums[label * 3] += p[0];
+            sums[label * 3 + 1] += p[2];
+            sums[label * 3 + 2] += 1;
+        }
+    }
+
+    for (size_t label = 1; label * 3 < sums.size(); label++)
+    {
+        double count = sums[label * 3 + 2];
+        if (count > 0)
+            _occupancy.add((int)label, frame.timestamp,
+                           (float)(sums[label * 3] / count),
+                           (float)(sums[label * 3 + 1] / count));
+    }
+}
+
+void Tracker::onSkeletons(const SkeletonFrame &frame)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _lastData = std::chrono::steady_clock::now();
+    _skeletonCount = (int)frame.skeletons.size();
+
+    if (_history.enabled() || _gestures.enabled())
+    {
+        float joints[HISTORY_JOINTS * 3];
+        float confidence[HISTORY_JOINTS];
+        for (const SkeletonState &skel : frame.skeletons)
+        {
+            for (int i = 0; i < HISTORY_JOINTS; i++)
+            {
+                const JointState &joint = skel.joints[i];
+                std::copy(joint.real, joint.real + 3, joints + i * 3);
+                _toOutputFrame(joints + i * 3);
+                confidence[i] = joint.confidence;
+            }
+            _history.pushSkeleton(skel.userId, frame.timestamp, joints,
+                                  confidence);
+            _gestures.push(skel.userId, joints);
+        }
+    }
+
+    if (_occupancy.enabled() && !_occupancyFromMask)
+    {
+        for (const SkeletonState &skel : frame.skeletons)
+        {
+            // Torso, in the order of the "Skeleton" tuple.
+            const JointState &torso = skel.joints[2];
+            if (torso.confidence <= 0)
+                continue;
+
+            float p[3];
+            _world.apply(torso.real, p);
+            _occupancy.add(skel.userId, frame.timestamp, p[0], p[2]);
+        }
+    }
+
+    if (_gestures.enabled())
+    {
+        std::vector<GestureMatcher::Match> matches;
+        _gestures.match(matches);
+        if (_templateGestureCallback && !matches.empty())
+            _templateGestureCallback(matches);
+    }
+
+    if (_skeletonCallback &&
+        _gates[STREAM_SKELETON].accept(frame.timestamp, _usersPresent()))
+    {
+        if (_worldFrame)
+        {
+            _worldSkeletons = frame;
+            for (SkeletonState &skel : _worldSkeletons.skeletons)
+                for (JointState &joint : skel.joints)
+                {
+                    _toOutputFrame(joint.real);
+                    _rotateToOutputFrame(joint.orient);
+                }
+            _skeletonCallback(_worldSkeletons);
+        }
+        else
+            _skeletonCallback(frame);
+    }
+
+    if (_faceCallback &&
+        _gates[STREAM_FACE].accept(frame.timestamp, _usersPresent()))
+        _faceCallback(_device->facesJson());
+}
+
+void Tracker::onDepthFrame(const DepthImage &frame)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _lastData = std::chrono::steady_clock::now();
+    const uint16_t *depthPtr = frame.data;
+    int nCols = frame.cols;
+    int nRows = frame.rows;
+
+    // The user frame of the previous depth frame never came.
+    if (_voxelsPending)
+        _integrateVoxels(false);
+
+    // The latest frame is kept for the point cloud queries.
+    _depthBuffer.resize((size_t)nRows * nCols);
+    if (_depthFilter.enabled())
+        _depthFilter.apply(depthPtr, _depthBuffer.data(), nRows, nCols);
+    else
+        std::memcpy(_depthBuffer.data(), depthPtr,
+                    _depthBuffer.size() * sizeof(uint16_t));
+    depthPtr = _depthBuffer.data();
+    _depthRows = nRows;
+    _depthCols = nCols;
+    _depthTimestamp = frame.timestamp;
+    _depthIntrinsics = Intrinsics(nCols, nRows, _depthMode.hfov);
+
+    _floor.submit(depthPtr, nRows, nCols, _depthIntrinsics);
+    Plane floor;
+    float confidence;
+    if (_floor.plane(floor, confidence))
+    {
+        _world = floor.worldTransform();
+        // Occupancy was accumulated in the camera frame until now.
+        if (!_floorFound)
+            _occupancy.changeFrame();
+        _floorFound = true;
+    }
+
+    // Labels must come from the same frame, or silhouette edges would
+    // label the background. The device may give either frame first.
+    if (_voxels.enabled())
+    {
+        if (!_labelBuffer.empty() && _labelTimestamp == frame.timestamp)
+            _integrateVoxels(true);
+        else
+            _voxelsPending = true;
+    }
+
+    if ((_depthCallback || _compressedDepthCallback) &&
+        _gates[STREAM_DEPTH].accept(frame.timestamp, _usersPresent()))
+    {
+        if (_compressedDepthCallback)
+        {
+            _codec.compressDepth(depthPtr, nRows, nCols, _compressed);
+            CompressedImage image = {frame.timestamp, _compressed.data(),
+                                     _compressed.size()};
+            _compressedDepthCallback(image);
+        }
+        else
+        {
+            DepthImage filtered = {frame.timestamp, nRows, nCols, depthPtr};
+            _depthCallback(filtered);
+        }
+    }
+}
+
+void Tracker::onColorFrame(const ColorImage &frame)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (_colorCallback &&
+        _gates[STREAM_COLOR].accept(frame.timestamp, _usersPresent()))
+        _colorCallback(frame);
+}
+
+void Tracker::onHands(const HandFrame &frame)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (_history.enabled())
+    {
+        for (const UserHandsState &hands : frame.users)
+        {
+            const HandState *userHands[HISTORY_HANDS] = {&hands.left,
+                                                         &hands.right};
+            float real[HISTORY_HANDS * 3];
+            uint8_t click[HISTORY_HANDS];
+            int32_t pressure[HISTORY_HANDS];
+            for (int i = 0; i < HISTORY_HANDS; i++)
+            {
+                const HandState &hand = *userHands[i];
+                real[i * 3] = hand.tracked ? hand.real[0] : NAN;
+                real[i * 3 + 1] = hand.tracked ? hand.real[1] : NAN;
+                real[i * 3 + 2] = hand.tracked ? hand.real[2] : NAN;
+                _toOutputFrame(real + i * 3);
+                click[i] = hand.tracked && hand.click;
+                pressure[i] = hand.tracked ? hand.pressure : 0;
+            }
+            _history.pushHands(hands.userId, frame.timestamp, real, click,
+                               pressure);
+        }
+    }
+
+    if (_handsCallback &&
+        _gates[STREAM_HANDS].accept(frame.timestamp, _usersPresent()))
+    {
+        if (_worldFrame)
+        {
+            _worldHands = frame;
+            for (UserHandsState &hands : _worldHands.users)
+            {
+                _toOutputFrame(hands.left.real);
+                _toOutputFrame(hands.right.real);
+            }
+            _handsCallback(_worldHands);
+        }
+        else
+            _handsCallback(frame);
+    }
+}
+
+void Tracker::onNewUser(int userId)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _trackedUsers.insert(userId);
+}
+
+void Tracker::onLostUser(int userId)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _trackedUsers.erase(userId);
+    _history.evict(userId);
+    _gestures.evict(userId);
+    _occupancy.evict(userId);
+}
+
+void Tracker::setHistoryCapacity(size_t capacity)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _history.setCapacity(capacity);
+}
+
+size_t Tracker::skeletonHistory(int userId, double seconds,
+                                std::vector<uint64_t> &timestamp,
+                                std::vector<float> &joints,
+                                std::vector<float> &confidence)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    const UserHistory *user = _history.find(userId);
+    if (!user)
+    {
+        timestamp.clear();
+        joints.clear();
+        confidence.clear();
+        return 0;
+    }
+    return user->skeletonWindow(seconds, timestamp, joints, confidence);
+}
+
+size_t Tracker::handHistory(int userId, double seconds,
+                            std::vector<uint64_t> &timestamp,
+                            std::vector<float> &hands,
+                            std::vector<uint8_t> &click,
+                            std::vector<int32_t> &pressure)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    const UserHistory *user = _history.find(userId);
+    if (!user)
+    {
+        timestamp.clear();
+        hands.clear();
+        click.clear();
+        pressure.clear();
+        return 0;
+    }
+    return user->handWindow(seconds, timestamp, hands, click, pressure);
+}
+
+std::vector<int> Tracker::historyUsers()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _history.users();
+}
+
+int Tracker::addGestureTemplate(const float *joints, size_t length,
+                                float threshold)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    int templateId = _gestures.addTemplate(joints, length, threshold);
+    if (templateId < 0)
+        throw NuitrackException("Gesture template must have at least 2 frames.");
+    return templateId;
+}
+
+bool Tracker::removeGestureTemplate(int templateId)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _gestures.removeTemplate(templateId);
+}
+
+void Tracker::clearGestureTemplates()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _gestures.clear();
+}
+
+void Tracker::setDepthFilter(const DepthFilterConfig &config)
+{
+    if (config.medianWindow != 3 && config.medianWindow != 5)
+        throw NuitrackException("Median window must be 3 or 5.");
+
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _depthFilter.configure(config);
+    _offlineFilter.configure(config);
+}
+
+void Tracker::filterDepth(const uint16_t *in, uint16_t *out, int rows,
+                          int cols)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _offlineFilter.apply(in, out, rows, cols);
+}
+
+void Tracker::depthFilterStats(bool offline, uint64_t &frames,
+                               double &fillTemporalMs, double &edgeMs)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    const DepthFilter &filter = offline ? _offlineFilter : _depthFilter;
+    frames = filter.frames();
+    fillTemporalMs = filter.passTime(0);
+    edgeMs = filter.passTime(1);
+}
+
+void Tracker::_toOutputFrame(float *point) const
+{
+    if (_worldFrame)
+        _world.apply(point, point);
+}
+
+void Tracker::_rotateToOutputFrame(float *orient) const
+{
+    if (!_worldFrame)
+        return;
+
+    float rotated[9];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            rotated[i * 3 + j] = _world.r[i * 3] * orient[j] +
+                                 _world.r[i * 3 + 1] * orient[3 + j] +
+                                 _world.r[i * 3 + 2] * orient[6 + j];
+    std::memcpy(orient, rotated, sizeof(rotated));
+}
+
+void Tracker::setFloorEstimation(bool enable, int stride, double interval)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (enable)
+        _floor.start(stride, interval);
+    else
+        _floor.stop();
+}
+
+bool Tracker::floorPlane(Plane &plane, float &confidence)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _floor.plane(plane, confidence);
+}
+
+void Tracker::setWorldFrame(bool enable)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _worldFrame = enable;
+}
+
+size_t Tracker::pointCloud(int stride, std::vector<float> &points)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    stride = std::max(stride, 1);
+    points.clear();
+    for (int r = 0; r < _depthRows; r += stride)
+    {
+        const uint16_t *row = &_depthBuffer[(size_t)r * _depthCols];
+        for (int c = 0; c < _depthCols; c += stride)
+        {
+            if (!row[c])
+                continue;
+
+            float p[3];
+            _depthIntrinsics.backproject((float)c, (float)r, row[c], p);
+            _toOutputFrame(p);
+            points.insert(points.end(), p, p + 3);
+        }
+    }
+    return points.size() / 3;
+}
+
+void Tracker::setOccupancyGrid(const OccupancyGrid &grid, bool fromMask)
+{
+    if (grid.cellSize <= 0)
+        throw NuitrackException("Occupancy cell size must be positive.");
+
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _occupancy.configure(grid);
+    _occupancyFromMask = fromMask;
+}
+
+void Tracker::occupancy(OccupancyGrid &grid, std::vector<uint32_t> &counts,
+                        std::vector<float> &dwell,
+                        std::map<int, OccupancyMap::Track> &tracks)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    grid = _occupancy.grid();
+    counts = _occupancy.counts();
+    const std::vector<double> &total = _occupancy.dwell();
+    dwell.assign(total.begin(), total.end());
+    tracks = _occupancy.tracks();
+}
+
+void Tracker::resetOccupancy()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _occupancy.reset();
+}
+
+void Tracker::setVoxelGrid(const VoxelGridConfig &config)
+{
+    if (config.voxelSize <= 0)
+        throw NuitrackException("Voxel size must be positive.");
+
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _voxels.configure(config);
+    _voxelsPending = false;
+}
+
+VoxelGridConfig Tracker::voxelGridConfig()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _voxels.config();
+}
+
+void Tracker::occupiedVoxels(float threshold, std::vector<int32_t> &coords,
+                             std::vector<float> &scores,
+                             std::vector<uint16_t> &labels)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _voxels.occupied(threshold, coords, scores, labels);
+}
+
+void Tracker::voxelVolume(float threshold, std::vector<uint8_t> &occupancy,
+                          std::vector<uint16_t> &labels)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _voxels.volume(threshold, occupancy, labels);
+}
+
+bool Tracker::_usersPresent() const
+{
+    return !_trackedUsers.empty() || _skeletonCount > 0;
+}
+
+void Tracker::streamStats(Stream stream, uint64_t &delivered,
+                          uint64_t &skipped)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    delivered = _gates[stream].delivered();
+    skipped = _gates[stream].skipped();
+}
+
+void Tracker::setWatchdog(double timeout, int maxAttempts)
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _watchdogTimeout = std::max(timeout, 0.0);
+    _watchdogAttempts = maxAttempts;
+    _lastData = std::chrono::steady_clock::now();
+    _idleTime = 0;
+    _monitorCv.notify_all();
+}
+
+WatchdogStats Tracker::watchdogStats()
+{
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _watchdogStats;
+}
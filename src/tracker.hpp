@@ -0,0 +1,822 @@
+/**
+ * @file tracker.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the Tracker class, the native core of pynuitrack.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef tracker_H
+#define tracker_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "codec.hpp"
+#include "depthfilter.hpp"
+#include "device.hpp"
+#include "exception.hpp"
+#include "floor.hpp"
+#include "frames.hpp"
+#include "geometry.hpp"
+#include "gestures.hpp"
+#include "history.hpp"
+#include "occupancy.hpp"
+#include "streamgate.hpp"
+#include "threadpool.hpp"
+#include "voxelgrid.hpp"
+
+/// Receives depth frames (after the depth filters) or user label frames.
+typedef std::function<void(const DepthImage &)> DepthCallback;
+
+/// Receives color frames.
+typedef std::function<void(const ColorImage &)> ColorCallback;
+
+/// Receives compressed depth or user label frames.
+typedef std::function<void(const CompressedImage &)> CompressedCallback;
+
+/// Receives the tracked skeletons.
+typedef std::function<void(const SkeletonFrame &)> SkeletonCallback;
+
+/// Receives the face tracking data, as the JSON given by Nuitrack.
+typedef std::function<void(const std::string &)> FaceCallback;
+
+/// Receives the tracked hands.
+typedef std::function<void(const HandFrame &)> HandsCallback;
+
+/// Receives the built-in gestures detected by the sensor.
+typedef std::function<void(const std::vector<GestureEvent> &)> GestureCallback;
+
+/// Receives the gestures matched against the user-defined templates.
+typedef std::function<void(const std::vector<GestureMatcher::Match> &)>
+    TemplateGestureCallback;
+
+/// Receives the tracking issues.
+typedef std::function<void(const std::vector<IssueEvent> &)> IssueCallback;
+
+/**
+ * @brief Counters of the device watchdog.
+ */
+struct WatchdogStats
+{
+    /// Updates that failed with an error.
+    uint64_t failures;
+
+    /// Times the device gave no data for longer than the timeout.
+    uint64_t stalls;
+
+    /// Updates still blocked in the device after the timeout.
+    uint64_t hangs;
+
+    /// Successful re-initializations of the device.
+    uint64_t recoveries;
+
+    /// Re-initializations abandoned after the maximum number of attempts.
+    uint64_t failedRecoveries;
+
+    /// Duration of the latest recovery, in milliseconds.
+    double lastRecoveryMs;
+
+    /// Duration of the longest recovery, in milliseconds.
+    double maxRecoveryMs;
+
+    /// Total duration of all recoveries, in milliseconds.
+    double totalRecoveryMs;
+
+    /// Error or stall that triggered the latest recovery.
+    std::string lastError;
+
+    WatchdogStats()
+        : failures(0), stalls(0), hangs(0), recoveries(0), failedRecoveries(0),
+          lastRecoveryMs(0), maxRecoveryMs(0), totalRecoveryMs(0)
+    {
+    }
+};
+
+/**
+ * @brief Drives a device and its native processing stages.
+ * 
+ * This is the C++ core of pynuitrack, and has no dependency on Python. It
+ * buffers and post-processes the data of the device (depth filters, floor
+ * estimation, trajectory history, gesture templates, occupancy, voxel grid,
+ * compression and rate limiting) and delivers typed frames to the callbacks.
+ * 
+ * Callbacks are called by the thread updating the device, with the state
+ * locked, so they may call the getters but should return quickly. Each
+ * stream callback can be rate limited (see StreamGate). Data given to the
+ * callbacks is only valid during the call.
+ * 
+ * When the watchdog is enabled (see setWatchdog()), a device that fails or
+ * stops producing data is released and initialized again, keeping the
+ * callbacks and the configuration. A monitor thread watches updates that
+ * block inside the device.
+ * 
+ * 3D data is given in the camera frame, or in the world frame defined by
+ * the floor when setWorldFrame() is enabled. Projective coordinates are
+ * normalized.
+ */
+class Tracker : public FrameSink
+{
+private:
+    /// Output mode of the depth image.
+    StreamMode _depthMode;
+
+    /// Output mode of the color image.
+    StreamMode _colorMode;
+
+    /// Source of the data. NULL until init() is called.
+    std::unique_ptr<Device> _device;
+
+    /// Thread updating the device, started by start().
+    std::thread _worker;
+
+    /// Whether the worker thread must keep running.
+    std::atomic<bool> _running;
+
+    /// Error that stopped the worker thread, if any.
+    std::string _workerError;
+
+    /// Called by the worker thread when it starts.
+    std::function<void()> _workerStart;
+
+    /// Called by the worker thread before it ends.
+    std::function<void()> _workerStop;
+
+    /// Longest time without data before the device is considered stalled,
+    /// in seconds. Zero disables the watchdog.
+    double _watchdogTimeout;
+
+    /// Re-initializations tried before a failure is given up.
+    int _watchdogAttempts;
+
+    /// Counters of the watchdog.
+    WatchdogStats _watchdogStats;
+
+    /// Time of the latest data given by the device.
+    std::chrono::steady_clock::time_point _lastData;
+
+    /// Whether an update watched by the watchdog is in progress.
+    bool _updating;
+
+    /// Time at which the update in progress started.
+    std::chrono::steady_clock::time_point _updateStart;
+
+    /// Time (s) spent inside updates since the latest data. Pauses between
+    /// updates do not count, as the caller may not update the device.
+    double _idleTime;
+
+    /// Set by the monitor when the update in progress has hung.
+    bool _hung;
+
+    /// Thread flagging hung updates, started by the first watched update.
+    std::thread _monitor;
+
+    /// Wakes the monitor when the watchdog changes or must stop.
+    std::condition_variable_any _monitorCv;
+
+    /// Tells the monitor thread to exit.
+    bool _monitorStop;
+
+    /// Protects the state shared by the device thread and the getters.
+    /// Recursive, so the callbacks can call the getters.
+    std::recursive_mutex _mutex;
+
+    /// Callback for the depth image.
+    DepthCallback _depthCallback;
+
+    /// Callback for the compressed depth image.
+    CompressedCallback _compressedDepthCallback;
+
+    /// Callback for the color image.
+    ColorCallback _colorCallback;
+
+    /// Callback for the user label image.
+    DepthCallback _userCallback;
+
+    /// Callback for the compressed user label image.
+    CompressedCallback _compressedUserCallback;
+
+    /// Callback for the skeleton tracking.
+    SkeletonCallback _skeletonCallback;
+
+    /// Callback for the face tracking.
+    FaceCallback _faceCallback;
+
+    /// Callback for the hand tracking.
+    HandsCallback _handsCallback;
+
+    /// Callback for the built-in gestures.
+    GestureCallback _gestureCallback;
+
+    /// Callback for the gesture templates.
+    TemplateGestureCallback _templateGestureCallback;
+
+    /// Callback for the tracking issues.
+    IssueCallback _issueCallback;
+
+    /// Trajectory history of each tracked user.
+    HistoryStore _history;
+
+    /// Threads of the native processing stages, shared by all trackers.
+    ThreadPool *_pool;
+
+    /// Recognizer for the user-defined gesture templates.
+    GestureMatcher _gestures;
+
+    /// Post-processing filters applied to the depth frames.
+    DepthFilter _depthFilter;
+
+    /// Filters with the same configuration, applied by filterDepth() so
+    /// offline frames do not touch the state of the depth stream.
+    DepthFilter _offlineFilter;
+
+    /// Latest (filtered) depth frame.
+    std::vector<uint16_t> _depthBuffer;
+
+    /// Number of rows of the latest depth frame.
+    int _depthRows;
+
+    /// Number of columns of the latest depth frame.
+    int _depthCols;
+
+    /// Intrinsics of the depth camera, updated with each depth frame.
+    Intrinsics _depthIntrinsics;
+
+    /// Background estimator of the floor plane.
+    FloorEstimator _floor;
+
+    /// Whether 3D data is given in the world frame defined by the floor.
+    bool _worldFrame;
+
+    /// Transform from the camera frame to the world frame (identity until
+    /// the floor is found).
+    RigidTransform _world;
+
+    /// Whether the floor was found, so _world is no longer the identity.
+    bool _floorFound;
+
+    /// Occupancy and dwell-time accumulator.
+    OccupancyMap _occupancy;
+
+    /// Whether users are located by their mask centroid instead of torso.
+    bool _occupancyFromMask;
+
+    /// Occupancy volume built from the depth stream.
+    VoxelGrid _voxels;
+
+    /// Latest user label image, kept for the voxel grid.
+    std::vector<uint16_t> _labelBuffer;
+
+    /// Timestamp of the latest user label image, in microseconds.
+    uint64_t _labelTimestamp;
+
+    /// Timestamp of the latest depth frame, in microseconds.
+    uint64_t _depthTimestamp;
+
+    /// Whether the latest depth frame waits for its labels before being
+    /// added to the voxel grid.
+    bool _voxelsPending;
+
+    /// Delivery gate of each stream, indexed by Stream.
+    StreamGate _gates[STREAM_COUNT];
+
+    /// Codec of the compressed depth and user streams.
+    FrameCodec _codec;
+
+    /// Latest compressed frame.
+    std::vector<uint8_t> _compressed;
+
+    /// Skeletons converted to the world frame.
+    SkeletonFrame _worldSkeletons;
+
+    /// Hands converted to the world frame.
+    HandFrame _worldHands;
+
+    /// Users currently tracked by the user tracker.
+    std::set<int> _trackedUsers;
+
+    /// Number of skeletons in the latest skeleton data.
+    int _skeletonCount;
+
+    /**
+     * @brief Returns whether any user is currently tracked.
+     */
+    bool _usersPresent() const;
+
+    /**
+     * @brief Adds the mask centroid of each user to the occupancy map.
+     * 
+     * @param frame User label image.
+     */
+    void _addMaskCentroids(const DepthImage &frame);
+
+    /**
+     * @brief Adds the latest depth frame to the voxel grid.
+     * 
+     * @param labeled Whether the latest user label image belongs to it.
+     */
+    void _integrateVoxels(bool labeled);
+
+    /**
+     * @brief Converts a point from the camera frame to the output frame.
+     * 
+     * @param point Real coordinates, converted in place.
+     */
+    void _toOutputFrame(float *point) const;
+
+    /**
+     * @brief Rotates an orientation from the camera frame to the output
+     *      frame.
+     * 
+     * @param orient Row-major 3x3 orientation, rotated in place.
+     */
+    void _rotateToOutputFrame(float *orient) const;
+
+    /**
+     * @brief Updates the device once, recovering it from failures and stalls
+     *      when the watchdog is enabled.
+     */
+    void _updateDevice();
+
+    /**
+     * @brief Releases and initializes the device again, keeping the state of
+     *      the tracker. Throws the last error if every attempt fails.
+     * 
+     * @param reason Error or stall that triggered the recovery.
+     */
+    void _recover(const std::string &reason);
+
+    /**
+     * @brief Flags the update in progress once it has given no data for
+     *      longer than the timeout, and interrupts the device.
+     */
+    void _monitorLoop();
+
+    /**
+     * @brief Stops and joins the monitor thread, if any.
+     */
+    void _stopMonitor();
+
+    /**
+     * @brief Updates the device until stop() is called.
+     */
+    void _workerLoop();
+
+    /**
+     * @brief Stops and joins the worker thread, if any.
+     * 
+     * @return std::string Error that stopped the worker, or empty.
+     */
+    std::string _stopWorker();
+
+    // FrameSink callbacks, called by the device.
+    void onDepthFrame(const DepthImage &frame);
+    void onColorFrame(const ColorImage &frame);
+    void onUserFrame(const DepthImage &frame);
+    void onSkeletons(const SkeletonFrame &frame);
+    void onHands(const HandFrame &frame);
+    void onGestures(const std::vector<GestureEvent> &gestures);
+    void onIssues(const std::vector<IssueEvent> &issues);
+    void onNewUser(int userId);
+    void onLostUser(int userId);
+
+public:
+    /**
+     * @brief Construct a new, uninitialized, Tracker object.
+     */
+    Tracker();
+
+    /**
+     * @brief Destroy the Tracker object, stopping and releasing its device.
+     */
+    ~Tracker();
+
+    /**
+     * @brief Opens a device and starts its modules.
+     * 
+     * @param configPath Path to Nuitrack configuration file.
+     * @param device Empty for the default sensor, a sensor serial number
+     *      (see listDevices()), or "sim[:fps[:users[:faults]]]" for a
+     *      simulated device (see createDevice()).
+     */
+    void init(const std::string &configPath = "",
+              const std::string &device = "");
+
+    /**
+     * @brief Waits for new data from the device and feeds it to the
+     *      callbacks, on the calling thread.
+     */
+    void update();
+
+    /**
+     * @brief Starts a thread that updates the device continuously.
+     */
+    void start();
+
+    /**
+     * @brief Stops the thread started by start().
+     * 
+     * Throws the error that stopped the thread, if any.
+     */
+    void stop();
+
+    /**
+     * @brief Returns whether the thread started by start() is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Returns whether the caller is the thread started by start().
+     */
+    bool inWorkerThread() const;
+
+    /**
+     * @brief Sets functions called by the worker thread when it starts and
+     *      before it ends (e.g., to attach the thread to an interpreter).
+     * 
+     * @param onStart Called when the thread starts. May be empty.
+     * @param onStop Called before the thread ends. May be empty.
+     */
+    void setWorkerHooks(std::function<void()> onStart,
+                        std::function<void()> onStop);
+
+    /**
+     * @brief Stops the worker thread and releases the device.
+     * 
+     * Throws the error that stopped the worker thread, if any.
+     */
+    void release();
+
+    /**
+     * @brief Returns a description of the device, or empty if not
+     *      initialized.
+     */
+    std::string deviceName();
+
+    /**
+     * @brief Returns the output mode of the depth image.
+     */
+    StreamMode depthMode();
+
+    /**
+     * @brief Returns the output mode of the color image.
+     */
+    StreamMode colorMode();
+
+    /**
+     * @brief Sets the depth callback, replacing the compressed one.
+     * 
+     * @param callback Function receiving the filtered depth frames. Empty
+     *      to stop the stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setDepthCallback(DepthCallback callback, double rate = 0,
+                          int every = 1, bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the compressed depth callback, replacing the plain one.
+     * 
+     * @param callback Function receiving the filtered depth frames,
+     *      compressed with FrameCodec. Empty to stop the stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setCompressedDepthCallback(CompressedCallback callback,
+                                    double rate = 0, int every = 1,
+                                    bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the color callback.
+     * 
+     * @param callback Function receiving the BGR frames. Empty to stop the
+     *      stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setColorCallback(ColorCallback callback, double rate = 0,
+                          int every = 1, bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the user callback, replacing the compressed one.
+     * 
+     * @param callback Function receiving the user label frames. Empty to
+     *      stop the stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setUserCallback(DepthCallback callback, double rate = 0,
+                         int every = 1, bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the compressed user callback, replacing the plain one.
+     * 
+     * @param callback Function receiving the user label frames, compressed
+     *      with FrameCodec. Empty to stop the stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setCompressedUserCallback(CompressedCallback callback,
+                                   double rate = 0, int every = 1,
+                                   bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the skeleton callback.
+     * 
+     * @param callback Function receiving the tracked skeletons. Empty to
+     *      stop the stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setSkeletonCallback(SkeletonCallback callback, double rate = 0,
+                             int every = 1, bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the face callback.
+     * 
+     * @param callback Function receiving the face data. Empty to stop the
+     *      stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setFaceCallback(FaceCallback callback, double rate = 0,
+                         int every = 1, bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the hands callback.
+     * 
+     * @param callback Function receiving the tracked hands. Empty to stop
+     *      the stream.
+     * @param rate Maximum delivery rate, in Hz. Zero means unlimited.
+     * @param every Deliver only one of every N frames.
+     * @param onlyWithUsers Whether to skip frames while no user is tracked.
+     */
+    void setHandsCallback(HandsCallback callback, double rate = 0,
+                          int every = 1, bool onlyWithUsers = false);
+
+    /**
+     * @brief Sets the callback of the built-in gestures.
+     * 
+     * @param callback Function receiving the gestures. May be empty.
+     */
+    void setGestureCallback(GestureCallback callback);
+
+    /**
+     * @brief Sets the callback of the gesture templates.
+     * 
+     * @param callback Function receiving the matches. May be empty.
+     */
+    void setTemplateGestureCallback(TemplateGestureCallback callback);
+
+    /**
+     * @brief Sets the callback of the tracking issues.
+     * 
+     * @param callback Function receiving the issues. May be empty.
+     */
+    void setIssueCallback(IssueCallback callback);
+
+    /**
+     * @brief Sets how many samples of trajectory history are kept per user.
+     * 
+     * @param capacity Number of samples per user. Zero disables the history.
+     */
+    void setHistoryCapacity(size_t capacity);
+
+    /**
+     * @brief Copies the last `seconds` of skeleton history of a user. See
+     *      UserHistory::skeletonWindow.
+     * 
+     * @return size_t Number of samples, zero if the user is not stored.
+     */
+    size_t skeletonHistory(int userId, double seconds,
+                           std::vector<uint64_t> &timestamp,
+                           std::vector<float> &joints,
+                           std::vector<float> &confidence);
+
+    /**
+     * @brief Copies the last `seconds` of hand history of a user. See
+     *      UserHistory::handWindow.
+     * 
+     * @return size_t Number of samples, zero if the user is not stored.
+     */
+    size_t handHistory(int userId, double seconds,
+                       std::vector<uint64_t> &timestamp,
+                       std::vector<float> &hands, std::vector<uint8_t> &click,
+                       std::vector<int32_t> &pressure);
+
+    /**
+     * @brief Returns the IDs of all users with stored history.
+     */
+    std::vector<int> historyUsers();
+
+    /**
+     * @brief Registers a gesture template. See GestureMatcher::addTemplate.
+     * 
+     * @return int ID of the template.
+     */
+    int addGestureTemplate(const float *joints, size_t length,
+                           float threshold);
+
+    /**
+     * @brief Removes a gesture template.
+     * 
+     * @return true if the template existed.
+     */
+    bool removeGestureTemplate(int templateId);
+
+    /**
+     * @brief Removes all gesture templates.
+     */
+    void clearGestureTemplates();
+
+    /**
+     * @brief Configures the filters applied to the depth stream.
+     */
+    void setDepthFilter(const DepthFilterConfig &config);
+
+    /**
+     * @brief Applies the depth filters to an arbitrary depth image.
+     * 
+     * Uses its own filters, with the configuration of the depth stream, so
+     * the temporal state only carries over between calls of this method.
+     */
+    void filterDepth(const uint16_t *in, uint16_t *out, int rows, int cols);
+
+    /**
+     * @brief Returns the statistics of the depth filters.
+     * 
+     * @param offline Whether to return the statistics of filterDepth()
+     *      instead of those of the depth stream.
+     * @param[out] frames Number of filtered frames.
+     * @param[out] fillTemporalMs Total time of the hole filling/temporal
+     *      pass, in milliseconds.
+     * @param[out] edgeMs Total time of the edge-preserving pass, in
+     *      milliseconds.
+     */
+    void depthFilterStats(bool offline, uint64_t &frames,
+                          double &fillTemporalMs, double &edgeMs);
+
+    /**
+     * @brief Starts or stops estimating the floor plane. See
+     *      FloorEstimator::start.
+     */
+    void setFloorEstimation(bool enable, int stride = 8,
+                            double interval = 1.0);
+
+    /**
+     * @brief Returns the latest floor plane, in the camera frame.
+     * 
+     * @return true if the floor has been found.
+     */
+    bool floorPlane(Plane &plane, float &confidence);
+
+    /**
+     * @brief Sets whether 3D data is given in the world frame defined by the
+     *      floor, instead of the camera frame.
+     */
+    void setWorldFrame(bool enable);
+
+    /**
+     * @brief Back-projects the latest depth frame to the output frame.
+     * 
+     * @param stride Only every stride-th row and column is used.
+     * @param[out] points N x 3 points, in millimeters.
+     * @return size_t Number of points N.
+     */
+    size_t pointCloud(int stride, std::vector<float> &points);
+
+    /**
+     * @brief Sets the floor grid of the occupancy map, clearing it.
+     * 
+     * @param grid Grid, in the world frame.
+     * @param fromMask Whether users are located by their mask centroid
+     *      instead of their torso.
+     */
+    void setOccupancyGrid(const OccupancyGrid &grid, bool fromMask = false);
+
+    /**
+     * @brief Copies the occupancy map.
+     * 
+     * @param[out] grid Grid of the map.
+     * @param[out] counts Samples per cell, laid out as rows x cols.
+     * @param[out] dwell Dwell time per cell, laid out as rows x cols.
+     * @param[out] tracks Statistics of each tracked user.
+     */
+    void occupancy(OccupancyGrid &grid, std::vector<uint32_t> &counts,
+                   std::vector<float> &dwell,
+                   std::map<int, OccupancyMap::Track> &tracks);
+
+    /**
+     * @brief Clears the occupancy map.
+     */
+    void resetOccupancy();
+
+    /**
+     * @brief Sets the voxel grid, clearing it.
+     */
+    void setVoxelGrid(const VoxelGridConfig &config);
+
+    /**
+     * @brief Returns the configuration of the voxel grid.
+     */
+    VoxelGridConfig voxelGridConfig();
+
+    /**
+     * @brief Copies the occupied voxels. See VoxelGrid::occupied.
+     */
+    void occupiedVoxels(float threshold, std::vector<int32_t> &coords,
+                        std::vector<float> &scores,
+                        std::vector<uint16_t> &labels);
+
+    /**
+     * @brief Copies the whole voxel grid, with the occupancy packed in bits.
+     *      See VoxelGrid::volume.
+     */
+    void voxelVolume(float threshold, std::vector<uint8_t> &occupancy,
+                     std::vector<uint16_t> &labels);
+
+    /**
+     * @brief Enables the watchdog of the device.
+     * 
+     * Failed updates, and updates giving no data for longer than the
+     * timeout, release the device and initialize it again (for a sensor,
+     * the release/init/run sequence of the SDK). Callbacks, configuration,
+     * the occupancy cells and the voxel grid are kept. Tracked users are
+     * lost as after a real loss, which drops their history, gesture windows
+     * and occupancy paths, since the device restarts its user IDs and
+     * timestamps. Rate limits restart with the new timestamps.
+     * 
+     * An update still blocked after the timeout is counted as a hang by a
+     * monitor thread, which interrupts the device if it supports it (see
+     * Device::interrupt()). The SDK does not, so the device is only
+     * recovered once waitUpdate() returns.
+     * 
+     * The SDK session is shared by all sensors of the process, so while
+     * several sensors are in use a recovery only recreates the modules of
+     * this sensor, without repeating the release/init/run sequence.
+     * 
+     * @param timeout Longest time without data, in seconds, counting only
+     *      the time spent inside update(). Zero disables the watchdog, so
+     *      errors are thrown by update() and stop().
+     * @param maxAttempts Re-initializations tried before giving up and
+     *      throwing the error.
+     */
+    void setWatchdog(double timeout, int maxAttempts = 5);
+
+    /**
+     * @brief Returns the counters of the watchdog.
+     */
+    WatchdogStats watchdogStats();
+
+    /**
+     * @brief Returns the delivery counters of a stream.
+     * 
+     * @param stream Stream.
+     * @param[out] delivered Number of frames given to the callback.
+     * @param[out] skipped Number of frames dropped by the gate.
+     */
+    void streamStats(Stream stream, uint64_t &delivered, uint64_t &skipped);
+};
+
+#endif
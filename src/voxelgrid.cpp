@@ -0,0 +1,263 @@
+/**
+ * @file voxelgrid.cpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the VoxelGrid class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#include "voxelgrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+/// Scores below this value are dropped from the sparse storage.
+static const float MIN_SCORE = 0.05f;
+
+VoxelGrid::VoxelGrid(ThreadPool *pool) : _pool(pool)
+{
+}
+
+void VoxelGrid::configure(const VoxelGridConfig &config)
+{
+    _config = config;
+    _config.stride = std::max(_config.stride, 1);
+    _config.decay = std::min(std::max(_config.decay, 0.0f), 1.0f);
+    if (_config.nx < 0 || _config.ny < 0 || _config.nz < 0 ||
+        _config.voxelSize <= 0)
+        _config.nx = _config.ny = _config.nz = 0;
+    clear();
+}
+
+const VoxelGridConfig &VoxelGrid::config() const
+{
+    return _config;
+}
+
+bool VoxelGrid::enabled() const
+{
+    return _config.nx > 0 && _config.ny > 0 && _config.nz > 0;
+}
+
+void VoxelGrid::clear()
+{
+    _sparse.clear();
+    _dense.assign(enabled() && !_config.sparse ?
+                  (size_t)_config.nx * _config.ny * _config.nz : 0, Voxel());
+}
+
+void VoxelGrid::_decay()
+{
+    float decay = _config.decay;
+    if (decay >= 1.0f)
+        return;
+
+    if (!_config.sparse)
+    {
+        for (Voxel &voxel : _dense)
+        {
+            voxel.score *= decay;
+            if (voxel.score < MIN_SCORE)
+                voxel.label = 0;
+        }
+        return;
+    }
+
+    for (auto it = _sparse.begin(); it != _sparse.end();)
+    {
+        it->second.score *= decay;
+        if (it->second.score < MIN_SCORE)
+            it = _sparse.erase(it);
+        else
+            ++it;
+    }
+}
+
+void VoxelGrid::integrate(const uint16_t *depth, const uint16_t *labels,
+                          int rows, int cols, const Intrinsics &intrinsics,
+                          const RigidTransform &transform)
+{
+    if (!enabled() || !intrinsics.valid())
+        return;
+
+    _decay();
+
+    const int stride = _config.stride;
+    const int nx = _config.nx, ny = _config.ny, nz = _config.nz;
+    const float inv = 1.0f / _config.voxelSize;
+    const float *origin = _config.origin;
+
+    // A few chunks per thread, each one with its own hit buffer.
+    size_t chunks = _pool ? _pool->size() * 2 : 1;
+    size_t sampledRows = (rows + stride - 1) / stride;
+    chunks = std::max<size_t>(std::min(chunks, sampledRows), 1);
+    _partials.resize(chunks);
+
+    std::function<void(size_t, size_t)> body = [&](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            std::vector<uint64_t> &hits = _partials[chunk];
+            hits.clear();
+
+            size_t first = sampledRows * chunk / chunks;
+            size_t last = sampledRows * (chunk + 1) / chunks;
+            for (size_t s = first; s < last; s++)
+            {
+                int r = (int)s * stride;
+                const uint16_t *depthRow = depth + (size_t)r * cols;
+                const uint16_t *labelRow = labels ?
+                                           labels + (size_t)r * cols : NULL;
+                for (int c = 0; c < cols; c += stride)
+                {
+                    if (!depthRow[c])
+                        continue;
+
+                    float p[3];
+                    intrinsics.backproject((float)c, (float)r, depthRow[c], p);
+                    transform.apply(p, p);
+
+                    int x = (int)std::floor((p[0] - origin[0]) * inv);
+                    int y = (int)std::floor((p[1] - origin[1]) * inv);
+                    int z = (int)std::floor((p[2] - origin[2]) * inv);
+                    if (x < 0 || x >= nx || y < 0 || y >= ny || z < 0 ||
+                        z >= nz)
+                        continue;
+
+                    uint64_t index = ((uint64_t)z * ny + y) * nx + x;
+                    uint16_t label = labelRow ? labelRow[c] : 0;
+                    hits.push_back(index << 16 | label);
+                }
+            }
+        }
+    };
+
+    if (_pool)
+        _pool->parallelFor(chunks, body);
+    else
+        body(0, chunks);
+
+    // The label of each voxel hit by this frame is recomputed, so the
+    // background seen after a user left does not keep the user's label.
+    for (const std::vector<uint64_t> &hits : _partials)
+    {
+        for (uint64_t hit : hits)
+        {
+            Voxel &voxel = _config.sparse ? _sparse[hit >> 16]
+                                          : _dense[hit >> 16];
+            voxel.label = 0;
+            voxel.votes = 0;
+        }
+    }
+
+    // Boyer-Moore vote over the labeled hits, which finds the majority label
+    // in one pass without counting every label.
+    for (const std::vector<uint64_t> &hits : _partials)
+    {
+        for (uint64_t hit : hits)
+        {
+            Voxel &voxel = _config.sparse ? _sparse[hit >> 16]
+                                          : _dense[hit >> 16];
+            voxel.score += 1.0f;
+
+            uint16_t label = (uint16_t)(hit & 0xFFFF);
+            if (!label)
+                continue;
+            if (!voxel.votes)
+            {
+                voxel.label = label;
+                voxel.votes = 1;
+            }
+            else if (voxel.label == label)
+                voxel.votes += voxel.votes < 0xFFFF;
+            else
+                voxel.votes--;
+        }
+    }
+}
+
+void VoxelGrid::occupied(float threshold, std::vector<int32_t> &coords,
+                         std::vector<float> &scores,
+                         std::vector<uint16_t> &labels) const
+{
+    coords.clear();
+    scores.clear();
+    labels.clear();
+
+    const uint64_t nx = _config.nx, ny = _config.ny;
+    auto add = [&](uint64_t index, const Voxel &voxel)
+    {
+        coords.push_back((int32_t)(index % nx));
+        coords.push_back((int32_t)(index / nx % ny));
+        coords.push_back((int32_t)(index / nx / ny));
+        scores.push_back(voxel.score);
+        labels.push_back(voxel.label);
+    };
+
+    if (_config.sparse)
+    {
+        for (auto &voxel : _sparse)
+            if (voxel.second.score >= threshold)
+                add(voxel.first, voxel.second);
+    }
+    else
+    {
+        for (size_t i = 0; i < _dense.size(); i++)
+            if (_dense[i].score >= threshold)
+                add(i, _dense[i]);
+    }
+}
+
+void VoxelGrid::volume(float threshold, std::vector<uint8_t> &occupancy,
+                       std::vector<uint16_t> &labels) const
+{
+    size_t nx = enabled() ? _config.nx : 0;
+    size_t rowsYZ = enabled() ? (size_t)_config.ny * _config.nz : 0;
+    size_t rowBytes = (nx + 7) / 8;
+    occupancy.assign(rowsYZ * rowBytes, 0);
+    labels.assign(rowsYZ * nx, 0);
+
+    auto set = [&](size_t index, uint16_t label)
+    {
+        size_t row = index / nx, x = index % nx;
+        occupancy[row * rowBytes + x / 8] |= (uint8_t)(0x80 >> (x % 8));
+        labels[index] = label;
+    };
+
+    if (_config.sparse)
+    {
+        for (auto &voxel : _sparse)
+            if (voxel.second.score >= threshold)
+                set(voxel.first, voxel.second.label);
+    }
+    else
+    {
+        for (size_t i = 0; i < _dense.size(); i++)
+            if (_dense[i].score >= threshold)
+                set(i, _dense[i].label);
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * @file voxelgrid.hpp
+ * @author Silas Alves (silas.alves)
+ * @brief Contains the VoxelGrid class.
+ * @version 0.1
+ * @date 2019-09-03
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2019 Silas Franco dos Reis Alves
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+
+#ifndef voxelgrid_H
+#define voxelgrid_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "geometry.hpp"
+#include "threadpool.hpp"
+
+/**
+ * @brief Bounds, resolution and storage of a VoxelGrid.
+ */
+struct VoxelGridConfig
+{
+    VoxelGridConfig()
+        : voxelSize(50), nx(0), ny(0), nz(0), stride(2), decay(0),
+          sparse(false)
+    {
+        origin[0] = origin[1] = origin[2] = 0;
+    }
+
+    /// Coordinates (mm) of the corner of the first voxel.
+    float origin[3];
+
+    /// Side of each voxel, in millimeters.
+    float voxelSize;
+
+    /// Number of voxels along each axis. Zero disables the grid.
+    int nx, ny, nz;
+
+    /// Pixel stride used to subsample the depth frames.
+    int stride;
+
+    /// Fraction of the score kept from one frame to the next (0 to 1).
+    float decay;
+
+    /// Whether voxels are kept in a hash map instead of a dense array.
+    bool sparse;
+};
+
+/**
+ * @brief Coarse occupancy volume built from the depth stream.
+ *
+ * Each frame is back-projected and binned into voxels in parallel: rows are
+ * split in chunks, each chunk collects its hits in its own buffer, and the
+ * buffers are merged into the grid at the end, so threads never contend.
+ * Every voxel keeps a score (number of points, decayed over time) and the
+ * majority label of the points that hit it in the latest frame that did.
+ */
+class VoxelGrid
+{
+public:
+    /**
+     * @brief Contents of a voxel.
+     */
+    struct Voxel
+    {
+        Voxel() : score(0), label(0), votes(0) {}
+
+        /// Number of points, decayed over time.
+        float score;
+
+        /// Majority label of the labeled points of the latest frame that hit
+        /// the voxel (0 if none of them was labeled).
+        uint16_t label;
+
+        /// Vote count of the label while a frame is merged (saturated).
+        uint16_t votes;
+    };
+
+private:
+    /// Current configuration.
+    VoxelGridConfig _config;
+
+    /// Pool used to process rows in parallel (may be NULL).
+    ThreadPool *_pool;
+
+    /// Dense storage, indexed by (z * ny + y) * nx + x.
+    std::vector<Voxel> _dense;
+
+    /// Sparse storage, indexed as the dense one.
+    std::unordered_map<uint64_t, Voxel> _sparse;
+
+    /// Hits of each chunk, as (voxel index << 16 | label).
+    std::vector<std::vector<uint64_t> > _partials;
+
+    /**
+     * @brief Applies the temporal decay to all voxels.
+     */
+    void _decay();
+
+public:
+    /**
+     * @brief Construct a new, disabled, VoxelGrid object.
+     *
+     * @param pool Pool used to process rows in parallel, or NULL.
+     */
+    VoxelGrid(ThreadPool *pool = NULL);
+
+    /**
+     * @brief Sets the grid configuration and clears it.
+     *
+     * @param config New configuration.
+     */
+    void configure(const VoxelGridConfig &config);
+
+    /**
+     * @brief Returns the current configuration.
+     */
+    const VoxelGridConfig &config() const;
+
+    /**
+     * @brief Returns whether the grid is enabled.
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Clears all voxels.
+     */
+    void clear();
+
+    /**
+     * @brief Adds a depth frame to the grid.
+     *
+     * @param depth Depth frame, in millimeters.
+     * @param labels User label image of the same size, or NULL.
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     * @param intrinsics Intrinsics of the depth camera.
+     * @param transform Transform from the camera to the grid frame.
+     */
+    void integrate(const uint16_t *depth, const uint16_t *labels, int rows,
+                   int cols, const Intrinsics &intrinsics,
+                   const RigidTransform &transform);
+
+    /**
+     * @brief Lists the voxels whose score reaches a threshold.
+     *
+     * @param threshold Minimum score.
+     * @param[out] coords N x 3 voxel coordinates (x, y, z).
+     * @param[out] scores N scores.
+     * @param[out] labels N labels.
+     */
+    void occupied(float threshold, std::vector<int32_t> &coords,
+                  std::vector<float> &scores,
+                  std::vector<uint16_t> &labels) const;
+
+    /**
+     * @brief Fills dense volumes.
+     *
+     * The occupancy is a bit volume laid out as nz x ny x ceil(nx / 8)
+     * bytes, like numpy.packbits along x: the first voxel of each byte is its
+     * most significant bit, and each x row starts on a new byte.
+     *
+     * @param threshold Minimum score of an occupied voxel.
+     * @param[out] occupancy Occupancy bits.
+     * @param[out] labels Label of each occupied voxel, as nz x ny x nx.
+     */
+    void volume(float threshold, std::vector<uint8_t> &occupancy,
+                std::vector<uint16_t> &labels) const;
+};
+
+#endif